@@ -0,0 +1,300 @@
+/*
+Micro benchmarks of the unsigned integer operations and the polar code construction
+
+Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
+*/
+
+#include <bit>
+#include <array>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+#include "two_int.hh"
+#include "flat_int.hh"
+#include "two_int_montgomery.hh"
+#include "two_int_divider.hh"
+#include "polar_code.hh"
+
+template <typename TYPE>
+void keep(const TYPE &value)
+{
+	asm volatile ("" : : "r"(&value) : "memory");
+}
+
+inline uint64_t ticks()
+{
+#ifdef __x86_64__
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+struct Xorshift
+{
+	uint64_t state = 0x9e3779b97f4a7c15;
+	uint64_t operator()()
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+};
+
+template <typename TYPE>
+TYPE random_value(Xorshift &next)
+{
+	std::array<uint8_t, sizeof(TYPE)> bytes;
+	for (auto &byte: bytes)
+		byte = next();
+	return std::bit_cast<TYPE>(bytes);
+}
+
+struct Statistics
+{
+	double min, median, mean, stddev;
+};
+
+inline Statistics statistics(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	double sum = 0, squares = 0;
+	for (double v: values)
+		sum += v;
+	double mean = sum / values.size();
+	for (double v: values)
+		squares += (v - mean) * (v - mean);
+	return Statistics { values.front(), values[values.size() / 2], mean, std::sqrt(squares / values.size()) };
+}
+
+struct Benchmark
+{
+	bool json = false;
+	int repetitions = 15;
+	double target = 1e6;
+	const char *filter = nullptr;
+	bool first = true;
+	bool wanted(const std::string &name)
+	{
+		return !filter || name.find(filter) != std::string::npos;
+	}
+	template <typename FUNC>
+	void run(const char *group, const char *type, int bits, const char *op, int ops, FUNC func)
+	{
+		std::string name = std::string(group) + "/" + type + "/" + op;
+		if (!wanted(name))
+			return;
+		typedef std::chrono::steady_clock clock;
+		int rounds = 1;
+		while (true) {
+			auto start = clock::now();
+			for (int i = 0; i < rounds; ++i)
+				func();
+			double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+			if (elapsed >= target || rounds >= 1 << 24)
+				break;
+			rounds *= elapsed > 0 ? std::clamp(int(target / elapsed) + 1, 2, 16) : 16;
+		}
+		std::vector<double> nanos, cycles;
+		for (int r = 0; r < repetitions; ++r) {
+			auto start = clock::now();
+			uint64_t begin = ticks();
+			for (int i = 0; i < rounds; ++i)
+				func();
+			uint64_t end = ticks();
+			double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+			nanos.push_back(elapsed / (double(rounds) * ops));
+			cycles.push_back((end - begin) / (double(rounds) * ops));
+		}
+		report(group, type, bits, op, double(rounds) * ops, statistics(nanos), statistics(cycles));
+	}
+	void report(const char *group, const char *type, int bits, const char *op, double count, Statistics ns, Statistics tsc)
+	{
+		if (json) {
+			std::printf("%s{\"group\":\"%s\",\"type\":\"%s\",\"bits\":%d,\"op\":\"%s\",\"ops_per_rep\":%.0f,\"reps\":%d,"
+				"\"ns_min\":%.3f,\"ns_median\":%.3f,\"ns_mean\":%.3f,\"ns_stddev\":%.3f,"
+				"\"tsc_min\":%.3f,\"tsc_median\":%.3f,\"tsc_mean\":%.3f,\"tsc_stddev\":%.3f}",
+				first ? "[\n" : ",\n", group, type, bits, op, count, repetitions,
+				ns.min, ns.median, ns.mean, ns.stddev, tsc.min, tsc.median, tsc.mean, tsc.stddev);
+		} else {
+			if (first)
+				std::printf("group,type,bits,op,ops_per_rep,reps,ns_min,ns_median,ns_mean,ns_stddev,tsc_min,tsc_median,tsc_mean,tsc_stddev\n");
+			std::printf("%s,%s,%d,%s,%.0f,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+				group, type, bits, op, count, repetitions,
+				ns.min, ns.median, ns.mean, ns.stddev, tsc.min, tsc.median, tsc.mean, tsc.stddev);
+		}
+		std::fflush(stdout);
+		first = false;
+	}
+	void finish()
+	{
+		if (json)
+			std::printf(first ? "[]\n" : "\n]\n");
+	}
+};
+
+template <typename TYPE>
+void integer_ops(Benchmark &bench, const char *type)
+{
+	const int BITS = sizeof(TYPE) * 8;
+	const int N = 256;
+	Xorshift next;
+	std::vector<TYPE> a(N), b(N), d(N), r(N);
+	std::vector<decltype(mul(a[0], b[0]))> w(N);
+	std::vector<uint8_t> c(N);
+	for (int i = 0; i < N; ++i) {
+		a[i] = random_value<TYPE>(next);
+		b[i] = random_value<TYPE>(next);
+		d[i] = b[i] >> (BITS / 2) | TYPE(1);
+	}
+	auto binary = [&](const char *op, auto func) {
+		bench.run("int", type, BITS, op, N, [&]() {
+			for (int i = 0; i < N; ++i)
+				func(i);
+			keep(r[0]);
+			keep(w[0]);
+		});
+	};
+	binary("add", [&](int i){ r[i] = a[i] + b[i]; });
+	binary("sub", [&](int i){ r[i] = a[i] - b[i]; });
+	binary("add_assign", [&](int i){ r[i] += a[i]; });
+	binary("mul_low", [&](int i){ r[i] = a[i] * b[i]; });
+	binary("mul_wide", [&](int i){ w[i] = mul(a[i], b[i]); });
+	binary("div", [&](int i){ r[i] = a[i] / d[i]; });
+	binary("mod", [&](int i){ r[i] = a[i] % d[i]; });
+	binary("divmod", [&](int i){ w[i] = div(a[i], d[i]); });
+	binary("div_scalar", [&](int i){ r[i] = a[i] / uint64_t(10000); });
+	binary("div_same", [&](int i){ r[i] = a[i] / d[0]; });
+	TYPE small_divisor(10000);
+	binary("div_small", [&](int i){ r[i] = a[i] / small_divisor; });
+#ifdef __SIZEOF_INT128__
+	Divider<TYPE> divider(d[0]), small(small_divisor);
+	binary("div_divider", [&](int i){ r[i] = a[i] / divider; });
+	binary("mod_divider", [&](int i){ r[i] = a[i] % divider; });
+	binary("div_small_divider", [&](int i){ r[i] = a[i] / small; });
+#endif
+	binary("shl", [&](int i){ r[i] = a[i] << (i % BITS); });
+	binary("shr", [&](int i){ r[i] = a[i] >> (i % BITS); });
+	bench.run("int", type, BITS, "lt", N, [&]() {
+		for (int i = 0; i < N; ++i)
+			c[i] = a[i] < b[i];
+		keep(c[0]);
+	});
+	bench.run("int", type, BITS, "eq", N, [&]() {
+		for (int i = 0; i < N; ++i)
+			c[i] = a[i] == a[(i + 1) % N];
+		keep(c[0]);
+	});
+}
+
+#ifdef __SIZEOF_INT128__
+template <typename TYPE>
+void montgomery_ops(Benchmark &bench, const char *type)
+{
+	const int BITS = sizeof(TYPE) * 8;
+	Xorshift next;
+	TYPE m = random_value<TYPE>(next) | TYPE(1), a = random_value<TYPE>(next) % m, e = random_value<TYPE>(next);
+	MontgomeryContext<TYPE> ctx(m);
+	MontgomeryContext<TYPE, true> safe(m);
+	TYPE x = ctx.to_montgomery(a), r;
+	TwoInt<TYPE> wm;
+	wm.lower = m;
+	bench.run("montgomery", type, BITS, "mulmod_div", 1, [&]() {
+		r = (mul(a, a) % wm).lower;
+		keep(r);
+	});
+	bench.run("montgomery", type, BITS, "multiply", 1, [&]() {
+		r = ctx.multiply(x, x);
+		keep(r);
+	});
+	bench.run("montgomery", type, BITS, "square", 1, [&]() {
+		r = ctx.square(x);
+		keep(r);
+	});
+	bench.run("montgomery", type, BITS, "power", 1, [&]() {
+		r = ctx.power(a, e);
+		keep(r);
+	});
+	bench.run("montgomery", type, BITS, "power_ct", 1, [&]() {
+		r = safe.power(a, e);
+		keep(r);
+	});
+}
+#endif
+
+template <typename TYPE, int ORDER>
+void polar_const0(Benchmark &bench, const char *type)
+{
+	std::string op = "order" + std::to_string(ORDER);
+	auto freeze = new PolarCodeConst0<TYPE, ORDER>();
+	auto sequence = new int[1 << ORDER];
+	bench.run("polar_const0", type, sizeof(TYPE) * 8, op.c_str(), 1, [&]() {
+		(*freeze)(sequence, 3, 10);
+		keep(sequence[0]);
+	});
+	delete[] sequence;
+	delete freeze;
+}
+
+template <typename TYPE, int... ORDERS>
+void polar_orders(Benchmark &bench, const char *type)
+{
+	(polar_const0<TYPE, ORDERS>(bench, type), ...);
+}
+
+int main(int argc, char **argv)
+{
+	Benchmark bench;
+	for (int i = 1; i < argc; ++i) {
+		if (!std::strcmp(argv[i], "--json"))
+			bench.json = true;
+		else if (!std::strcmp(argv[i], "--reps") && i + 1 < argc)
+			bench.repetitions = std::max(1, std::atoi(argv[++i]));
+		else if (!std::strcmp(argv[i], "--min-ms") && i + 1 < argc)
+			bench.target = std::atof(argv[++i]) * 1e6;
+		else
+			bench.filter = argv[i];
+	}
+#ifdef __SIZEOF_INT128__
+	typedef TwoInt<uint64_t> u128;
+#else
+	typedef TwoInt<TwoInt<uint32_t>> u128;
+#endif
+	typedef TwoInt<u128> u256;
+	typedef TwoInt<u256> u512;
+	typedef TwoInt<u512> u1024;
+	typedef TwoInt<u1024> u2048;
+	typedef TwoInt<u2048> u4096;
+	integer_ops<TwoInt<uint8_t>>(bench, "TwoInt16");
+	integer_ops<TwoInt<uint16_t>>(bench, "TwoInt32");
+	integer_ops<TwoInt<uint32_t>>(bench, "TwoInt64");
+	integer_ops<u128>(bench, "TwoInt128");
+	integer_ops<u256>(bench, "TwoInt256");
+	integer_ops<u512>(bench, "TwoInt512");
+	integer_ops<u1024>(bench, "TwoInt1024");
+	integer_ops<u2048>(bench, "TwoInt2048");
+	integer_ops<u4096>(bench, "TwoInt4096");
+#ifdef __SIZEOF_INT128__
+	integer_ops<FlatInt<256>>(bench, "FlatInt256");
+	integer_ops<FlatInt<4096>>(bench, "FlatInt4096");
+	montgomery_ops<u256>(bench, "TwoInt256");
+	montgomery_ops<u1024>(bench, "TwoInt1024");
+#endif
+	polar_orders<u4096, 4, 6, 8, 10>(bench, "TwoInt4096");
+#ifdef __SIZEOF_INT128__
+	polar_orders<FlatInt<4096>, 4, 6, 8, 10>(bench, "FlatInt4096");
+#endif
+	polar_orders<double, 4, 6, 8, 10>(bench, "double");
+	bench.finish();
+	return 0;
+}
@@ -0,0 +1,506 @@
+/*
+Unsigned integer as flat array of 64 bit limbs
+
+Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
+*/
+
+#pragma once
+
+#include "two_int.hh"
+
+#ifdef __SIZEOF_INT128__
+template <int BITS>
+struct FlatInt
+{
+	static_assert(BITS >= 64 && BITS % 64 == 0, "BITS must be a multiple of 64");
+	static const int LIMBS = BITS / 64;
+	uint64_t limb[LIMBS];
+	constexpr FlatInt() : limb() {}
+	constexpr FlatInt(uint64_t value) : limb()
+	{
+		limb[0] = value;
+	}
+	static constexpr FlatInt<BITS> one()
+	{
+		return FlatInt<BITS>(1);
+	}
+	static constexpr FlatInt<BITS> max()
+	{
+		FlatInt<BITS> tmp;
+		for (int i = 0; i < LIMBS; ++i)
+			tmp.limb[i] = ~uint64_t(0);
+		return tmp;
+	}
+	constexpr void set(int index)
+	{
+		if (index < BITS)
+			limb[index / 64] |= uint64_t(1) << (index % 64);
+	}
+	constexpr void reset(int index)
+	{
+		if (index < BITS)
+			limb[index / 64] &= ~(uint64_t(1) << (index % 64));
+	}
+	constexpr bool get(int index)
+	{
+		if (index < BITS)
+			return limb[index / 64] & (uint64_t(1) << (index % 64));
+		return false;
+	}
+	explicit constexpr operator bool () const
+	{
+		for (int i = 0; i < LIMBS; ++i)
+			if (limb[i])
+				return true;
+		return false;
+	}
+	constexpr FlatInt<BITS> &operator|=(const FlatInt<BITS> &a)
+	{
+		for (int i = 0; i < LIMBS; ++i)
+			limb[i] |= a.limb[i];
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator&=(const FlatInt<BITS> &a)
+	{
+		for (int i = 0; i < LIMBS; ++i)
+			limb[i] &= a.limb[i];
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator^=(const FlatInt<BITS> &a)
+	{
+		for (int i = 0; i < LIMBS; ++i)
+			limb[i] ^= a.limb[i];
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator>>=(int i)
+	{
+		shift_limbs_right(limb, LIMBS, i);
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator<<=(int i)
+	{
+		shift_limbs_left(limb, LIMBS, i);
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator+=(const FlatInt<BITS> &a)
+	{
+		bool carry = false;
+		for (int i = 0; i < LIMBS; ++i)
+			carry = add_to(limb[i], a.limb[i], carry);
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator-=(const FlatInt<BITS> &a)
+	{
+		bool borrow = false;
+		for (int i = 0; i < LIMBS; ++i)
+			borrow = sub_from(limb[i], a.limb[i], borrow);
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator*=(const FlatInt<BITS> &a)
+	{
+		return *this = *this * a;
+	}
+	constexpr FlatInt<BITS> &operator/=(const FlatInt<BITS> &a)
+	{
+		return *this = *this / a;
+	}
+	constexpr FlatInt<BITS> &operator%=(const FlatInt<BITS> &a)
+	{
+		return *this = *this % a;
+	}
+	constexpr FlatInt<BITS> &operator+=(uint64_t a)
+	{
+		for (int i = 0; i < LIMBS && a; ++i) {
+			limb[i] += a;
+			a = limb[i] < a;
+		}
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator-=(uint64_t a)
+	{
+		for (int i = 0; i < LIMBS && a; ++i) {
+			uint64_t borrow = limb[i] < a;
+			limb[i] -= a;
+			a = borrow;
+		}
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator*=(uint64_t a)
+	{
+		uint64_t carry = 0;
+		for (int i = 0; i < LIMBS; ++i) {
+			unsigned __int128 tmp = (unsigned __int128)limb[i] * a + carry;
+			limb[i] = tmp;
+			carry = tmp >> 64;
+		}
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator/=(uint64_t a)
+	{
+		return *this = *this / a;
+	}
+	constexpr FlatInt<BITS> &operator%=(uint64_t a)
+	{
+		return *this = FlatInt<BITS>(*this % a);
+	}
+	constexpr FlatInt<BITS> &operator++()
+	{
+		for (int i = 0; i < LIMBS; ++i)
+			if (++limb[i])
+				break;
+		return *this;
+	}
+	constexpr FlatInt<BITS> &operator--()
+	{
+		for (int i = 0; i < LIMBS; ++i)
+			if (limb[i]--)
+				break;
+		return *this;
+	}
+	constexpr FlatInt<BITS> operator++(int)
+	{
+		FlatInt<BITS> tmp = *this;
+		++(*this);
+		return tmp;
+	}
+	constexpr FlatInt<BITS> operator--(int)
+	{
+		FlatInt<BITS> tmp = *this;
+		--(*this);
+		return tmp;
+	}
+};
+
+template <int BITS>
+constexpr bool operator==(const FlatInt<BITS> &a, const FlatInt<BITS> &b)
+{
+	for (int i = 0; i < FlatInt<BITS>::LIMBS; ++i)
+		if (a.limb[i] != b.limb[i])
+			return false;
+	return true;
+}
+
+template <int BITS>
+constexpr bool operator!=(const FlatInt<BITS> &a, const FlatInt<BITS> &b)
+{
+	return !(a == b);
+}
+
+template <int BITS>
+constexpr bool operator<(const FlatInt<BITS> &a, const FlatInt<BITS> &b)
+{
+	for (int i = FlatInt<BITS>::LIMBS - 1; i >= 0; --i)
+		if (a.limb[i] != b.limb[i])
+			return a.limb[i] < b.limb[i];
+	return false;
+}
+
+template <int BITS>
+constexpr bool operator>(const FlatInt<BITS> &a, const FlatInt<BITS> &b)
+{
+	return b < a;
+}
+
+template <int BITS>
+constexpr bool operator<=(const FlatInt<BITS> &a, const FlatInt<BITS> &b)
+{
+	return !(b < a);
+}
+
+template <int BITS>
+constexpr bool operator>=(const FlatInt<BITS> &a, const FlatInt<BITS> &b)
+{
+	return !(a < b);
+}
+
+template <int BITS>
+constexpr int clz(const FlatInt<BITS> &a)
+{
+	for (int i = FlatInt<BITS>::LIMBS - 1; i >= 0; --i)
+		if (a.limb[i])
+			return 64 * (FlatInt<BITS>::LIMBS - 1 - i) + std::countl_zero(a.limb[i]);
+	return BITS;
+}
+
+template <int BITS>
+constexpr int ctz(const FlatInt<BITS> &a)
+{
+	for (int i = 0; i < FlatInt<BITS>::LIMBS; ++i)
+		if (a.limb[i])
+			return 64 * i + std::countr_zero(a.limb[i]);
+	return BITS;
+}
+
+template <int BITS>
+constexpr int popcount(const FlatInt<BITS> &a)
+{
+	int count = 0;
+	for (int i = 0; i < FlatInt<BITS>::LIMBS; ++i)
+		count += std::popcount(a.limb[i]);
+	return count;
+}
+
+template <int BITS>
+constexpr int bit_width(const FlatInt<BITS> &a)
+{
+	return BITS - clz(a);
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator~(FlatInt<BITS> a)
+{
+	for (int i = 0; i < FlatInt<BITS>::LIMBS; ++i)
+		a.limb[i] = ~a.limb[i];
+	return a;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator|(FlatInt<BITS> a, const FlatInt<BITS> &b)
+{
+	return a |= b;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator&(FlatInt<BITS> a, const FlatInt<BITS> &b)
+{
+	return a &= b;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator^(FlatInt<BITS> a, const FlatInt<BITS> &b)
+{
+	return a ^= b;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator>>(FlatInt<BITS> a, int i)
+{
+	return a >>= i;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator<<(FlatInt<BITS> a, int i)
+{
+	return a <<= i;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator+(FlatInt<BITS> a, const FlatInt<BITS> &b)
+{
+	return a += b;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator-(FlatInt<BITS> a, const FlatInt<BITS> &b)
+{
+	return a -= b;
+}
+
+template <int BITS>
+constexpr bool add_to(FlatInt<BITS> &a, const FlatInt<BITS> &b, bool carry)
+{
+	for (int i = 0; i < FlatInt<BITS>::LIMBS; ++i)
+		carry = add_to(a.limb[i], b.limb[i], carry);
+	return carry;
+}
+
+template <int BITS>
+constexpr bool sub_from(FlatInt<BITS> &a, const FlatInt<BITS> &b, bool borrow)
+{
+	for (int i = 0; i < FlatInt<BITS>::LIMBS; ++i)
+		borrow = sub_from(a.limb[i], b.limb[i], borrow);
+	return borrow;
+}
+
+template <int BITS, int OTHER>
+constexpr bool add_shifted(FlatInt<BITS> &a, const FlatInt<OTHER> &b, int k)
+{
+	static_assert(OTHER <= BITS, "addend must not be wider than the sum");
+	return add_limbs_shifted(a.limb, FlatInt<BITS>::LIMBS, b.limb, FlatInt<OTHER>::LIMBS, k);
+}
+
+template <int BITS, int OTHER>
+constexpr bool sub_shifted(FlatInt<BITS> &a, const FlatInt<OTHER> &b, int k)
+{
+	static_assert(OTHER <= BITS, "subtrahend must not be wider than the difference");
+	return sub_limbs_shifted(a.limb, FlatInt<BITS>::LIMBS, b.limb, FlatInt<OTHER>::LIMBS, k);
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator*(const FlatInt<BITS> &a, const FlatInt<BITS> &b)
+{
+	const int LIMBS = FlatInt<BITS>::LIMBS;
+	FlatInt<BITS> tmp;
+	for (int i = 0; i < LIMBS; ++i) {
+		uint64_t carry = 0;
+		for (int j = 0; i + j < LIMBS; ++j) {
+			unsigned __int128 prod = (unsigned __int128)a.limb[i] * b.limb[j] + tmp.limb[i + j] + carry;
+			tmp.limb[i + j] = prod;
+			carry = prod >> 64;
+		}
+	}
+	return tmp;
+}
+
+template <int BITS>
+constexpr void multiply(uint64_t *prod, const FlatInt<BITS> &a, const FlatInt<BITS> &b)
+{
+	const int LIMBS = FlatInt<BITS>::LIMBS;
+	for (int i = 0; i < LIMBS; ++i)
+		prod[i] = 0;
+	for (int i = 0; i < LIMBS; ++i) {
+		uint64_t carry = 0;
+		for (int j = 0; j < LIMBS; ++j) {
+			unsigned __int128 tmp = (unsigned __int128)a.limb[i] * b.limb[j] + prod[i + j] + carry;
+			prod[i + j] = tmp;
+			carry = tmp >> 64;
+		}
+		prod[i + LIMBS] = carry;
+	}
+}
+
+template <int BITS>
+constexpr TwoInt<FlatInt<BITS>> mul(const FlatInt<BITS> &a, const FlatInt<BITS> &b)
+{
+	const int LIMBS = FlatInt<BITS>::LIMBS;
+	uint64_t prod[2 * LIMBS];
+	multiply(prod, a, b);
+	TwoInt<FlatInt<BITS>> tmp;
+	for (int i = 0; i < LIMBS; ++i) {
+		tmp.lower.limb[i] = prod[i];
+		tmp.upper.limb[i] = prod[i + LIMBS];
+	}
+	return tmp;
+}
+
+template <int BITS>
+constexpr void square(uint64_t *prod, const FlatInt<BITS> &a)
+{
+	const int LIMBS = FlatInt<BITS>::LIMBS;
+	for (int i = 0; i < 2 * LIMBS; ++i)
+		prod[i] = 0;
+	for (int i = 0; i < LIMBS; ++i) {
+		uint64_t carry = 0;
+		for (int j = i + 1; j < LIMBS; ++j) {
+			unsigned __int128 tmp = (unsigned __int128)a.limb[i] * a.limb[j] + prod[i + j] + carry;
+			prod[i + j] = tmp;
+			carry = tmp >> 64;
+		}
+		prod[i + LIMBS] = carry;
+	}
+	uint64_t carry = 0;
+	for (int i = 0; i < LIMBS; ++i) {
+		unsigned __int128 diag = (unsigned __int128)a.limb[i] * a.limb[i];
+		unsigned __int128 lower = ((unsigned __int128)prod[2 * i] << 1) + uint64_t(diag) + carry;
+		prod[2 * i] = lower;
+		unsigned __int128 upper = ((unsigned __int128)prod[2 * i + 1] << 1) + uint64_t(diag >> 64) + uint64_t(lower >> 64);
+		prod[2 * i + 1] = upper;
+		carry = upper >> 64;
+	}
+}
+
+template <int BITS>
+constexpr TwoInt<FlatInt<BITS>> sqr(const FlatInt<BITS> &a)
+{
+	const int LIMBS = FlatInt<BITS>::LIMBS;
+	uint64_t prod[2 * LIMBS];
+	square(prod, a);
+	TwoInt<FlatInt<BITS>> tmp;
+	for (int i = 0; i < LIMBS; ++i) {
+		tmp.lower.limb[i] = prod[i];
+		tmp.upper.limb[i] = prod[i + LIMBS];
+	}
+	return tmp;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> mulhi(const FlatInt<BITS> &a, const FlatInt<BITS> &b, int shift = 0)
+{
+	assert(shift >= 0 && shift < 64);
+	const int LIMBS = FlatInt<BITS>::LIMBS;
+	uint64_t prod[2 * LIMBS];
+	multiply(prod, a, b);
+	FlatInt<BITS> tmp;
+	for (int i = 0; i < LIMBS; ++i)
+		tmp.limb[i] = shift ? prod[i + LIMBS] << shift | prod[i + LIMBS - 1] >> (64 - shift) : prod[i + LIMBS];
+	return tmp;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> sqrhi(const FlatInt<BITS> &a, int shift = 0)
+{
+	assert(shift >= 0 && shift < 64);
+	const int LIMBS = FlatInt<BITS>::LIMBS;
+	uint64_t prod[2 * LIMBS];
+	square(prod, a);
+	FlatInt<BITS> tmp;
+	for (int i = 0; i < LIMBS; ++i)
+		tmp.limb[i] = shift ? prod[i + LIMBS] << shift | prod[i + LIMBS - 1] >> (64 - shift) : prod[i + LIMBS];
+	return tmp;
+}
+
+template <int BITS>
+constexpr TwoInt<FlatInt<BITS>> div(const FlatInt<BITS> &dividend, const FlatInt<BITS> &divisor)
+{
+	assert(divisor);
+	TwoInt<FlatInt<BITS>> tmp;
+	long_division<uint64_t, FlatInt<BITS>::LIMBS>(tmp.lower.limb, tmp.upper.limb, dividend.limb, divisor.limb, (bit_width(dividend) + 63) / 64, (bit_width(divisor) + 63) / 64);
+	return tmp;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator/(const FlatInt<BITS> &dividend, const FlatInt<BITS> &divisor)
+{
+	return div(dividend, divisor).lower;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator%(const FlatInt<BITS> &dividend, const FlatInt<BITS> &divisor)
+{
+	return div(dividend, divisor).upper;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator+(FlatInt<BITS> a, uint64_t b)
+{
+	return a += b;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator-(FlatInt<BITS> a, uint64_t b)
+{
+	return a -= b;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator*(FlatInt<BITS> a, uint64_t b)
+{
+	return a *= b;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> divmod(FlatInt<BITS> dividend, uint64_t divisor, uint64_t *remainder)
+{
+	assert(divisor);
+	uint64_t rem = 0;
+	for (int i = (bit_width(dividend) + 63) / 64 - 1; i >= 0; --i)
+		dividend.limb[i] = divide(rem, dividend.limb[i], divisor, &rem);
+	if (remainder)
+		*remainder = rem;
+	return dividend;
+}
+
+template <int BITS>
+constexpr FlatInt<BITS> operator/(const FlatInt<BITS> &dividend, uint64_t divisor)
+{
+	return divmod(dividend, divisor, nullptr);
+}
+
+template <int BITS>
+constexpr uint64_t operator%(const FlatInt<BITS> &dividend, uint64_t divisor)
+{
+	uint64_t remainder;
+	divmod(dividend, divisor, &remainder);
+	return remainder;
+}
+#endif
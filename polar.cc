@@ -4,83 +4,76 @@ Polar code bit reliability sequence example
 Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
 */
 
-#include <cassert>
 #include <iostream>
 #include <algorithm>
-#include "two_int.hh"
+#include <cstdlib>
+#include <cstdio>
+#include "flat_int.hh"
+#include "polar_code.hh"
 
-template <typename TYPE, int ORDER>
-struct PolarCodeConst0
+template <typename TYPE>
+int polar_batch_main(const char *path, int count, char **args, int threads)
 {
-	static const int LENGTH = 1 << ORDER;
-	TYPE prob[LENGTH];
-	void compute(TYPE pe, int i, int h)
-	{
-		if (h) {
-			compute((pe << 1) - (mul(pe, pe) << 1).upper, i, h/2);
-			compute((mul(pe, pe) << 1).upper, i+h, h/2);
-		} else {
-			prob[i] = pe;
-		}
-	}
-	int significant(int value) {
-		int msb = 0;
-		while (value >>= 1)
-			++msb;
-		return msb;
+	PolarCache cache;
+	if (!cache.open(path))
+		std::cerr << "creating new cache " << path << std::endl;
+	std::vector<PolarSequence> known, missing;
+	for (int i = 0; i < cache.count(); ++i) {
+		const PolarCacheEntry &entry = cache.entries[i];
+		const int32_t *seq = cache.sequence(entry);
+		known.push_back(PolarSequence { int(entry.order), int(entry.numerator), int(entry.denominator), int(entry.bits), std::vector<int32_t>(seq, seq + (1 << entry.order)) });
 	}
-	void operator()(int *sequence, int numerator = 1, int denominator = 2)
-	{
-		assert(numerator <= denominator);
-		int bits = sizeof(TYPE) * 8;
-		int shift = significant(numerator);
-		TYPE erasure_probability = TYPE(numerator) << bits - 1 - shift;
-		erasure_probability /= TYPE(denominator);
-		erasure_probability <<= shift;
-		compute(erasure_probability, 0, LENGTH / 2);
-		for (int i = 0; i < LENGTH; ++i)
-			sequence[i] = i;
-		std::sort(sequence, sequence+LENGTH, [this](int a, int b){ return prob[a] > prob[b]; });
-	}
-};
-
-template <int ORDER>
-struct PolarCodeConst0<double, ORDER>
-{
-	typedef double TYPE;
-	static const int LENGTH = 1 << ORDER;
-	TYPE prob[LENGTH];
-	void compute(TYPE pe, int i, int h)
-	{
-		if (h) {
-			compute(2.0 * pe - pe * pe, i, h/2);
-			compute(pe * pe, i+h, h/2);
-		} else {
-			prob[i] = pe;
+	cache.close();
+	for (int i = 0; i < count; ++i) {
+		PolarSequence point { 0, 0, 0, 0, {} };
+		if (std::sscanf(args[i], "%d:%d/%d", &point.order, &point.numerator, &point.denominator) != 3 || point.order < 0 || point.order > 30 || point.numerator < 0 || point.denominator < 1 || point.numerator > point.denominator) {
+			std::cerr << "invalid design point " << args[i] << ", expected ORDER:NUMERATOR/DENOMINATOR" << std::endl;
+			return 1;
 		}
+		auto it = std::find_if(known.begin(), known.end(), [&point](const PolarSequence &seq) {
+			return !(seq < point) && !(point < seq);
+		});
+		if (it != known.end() && it->bits == int(sizeof(TYPE) * 8))
+			continue;
+		if (it != known.end())
+			known.erase(it);
+		if (std::find_if(missing.begin(), missing.end(), [&point](const PolarSequence &seq) { return !(seq < point) && !(point < seq); }) == missing.end())
+			missing.push_back(point);
 	}
-	void operator()(int *sequence, int numerator = 1, int denominator = 2)
-	{
-		assert(numerator <= denominator);
-		TYPE erasure_probability = TYPE(numerator);
-		erasure_probability /= TYPE(denominator);
-		compute(erasure_probability, 0, LENGTH / 2);
-		for (int i = 0; i < LENGTH; ++i)
-			sequence[i] = i;
-		std::sort(sequence, sequence+LENGTH, [this](int a, int b){ return prob[a] > prob[b]; });
+	std::cerr << "cached: " << known.size() << " computing: " << missing.size() << std::endl;
+	for (auto &seq: polar_batch<TYPE>(missing, threads))
+		known.push_back(seq);
+	if (!polar_cache_write(path, known)) {
+		std::cerr << "could not write cache " << path << std::endl;
+		return 1;
 	}
-};
+	return 0;
+}
+
+static_assert(polar_sequence<TwoInt<TwoInt<TwoInt<uint32_t>>>, 5>(3, 10) == polar_sequence<double, 5>(3, 10));
+static_assert(polar_sequence<TwoInt<TwoInt<TwoInt<uint32_t>>>, 5, PolarCodeConst0>(3, 10) == polar_sequence<TwoInt<TwoInt<TwoInt<uint32_t>>>, 5>(3, 10));
 
-int main()
+int main(int argc, char **argv)
 {
+	int threads = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1;
 	const int ORDER = 10;
 	const int LENGTH = 1 << ORDER;
+#ifdef __SIZEOF_INT128__
+	typedef TwoInt<TwoInt<TwoInt<TwoInt<TwoInt<TwoInt<uint64_t>>>>>> TYPE;
+	//typedef FlatInt<4096> TYPE;
+#else
 	typedef TwoInt<TwoInt<TwoInt<TwoInt<TwoInt<TwoInt<TwoInt<uint32_t>>>>>>> TYPE;
+#endif
 	//typedef double TYPE;
 	std::cerr << "type bits: " << sizeof(TYPE) * 8 << std::endl;
-	auto freeze = new PolarCodeConst0<TYPE, ORDER>();
+	if (argc > 2)
+		return polar_batch_main<TYPE>(argv[2], argc - 3, argv + 3, threads);
+	auto freeze = new PolarCodeConst1<TYPE, ORDER>();
+	//auto freeze = new PolarCodeConst0<TYPE, ORDER>();
+	//auto freeze = new PolarCodeHybrid<TYPE, ORDER>();
+	//auto freeze = new PolarCodeRuntime<TYPE>(ORDER);
 	auto sequence = new int[LENGTH];
-	(*freeze)(sequence, 3, 10);
+	(*freeze)(sequence, 3, 10, threads);
 	std::cout << "static const int sequence[" << LENGTH << "] = { ";
 	for (int i = 0; i < LENGTH; ++i)
 		std::cout << sequence[i] << ", ";
@@ -0,0 +1,165 @@
+/*
+Memory mapped cache of polar code bit reliability sequences
+
+Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const char polar_cache_magic[8] = { 'P', 'O', 'L', 'A', 'R', 'S', 'E', 'Q' };
+const uint32_t polar_cache_version = 1;
+
+struct PolarCacheHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t count;
+};
+
+struct PolarCacheEntry
+{
+	uint32_t order;
+	uint32_t numerator;
+	uint32_t denominator;
+	uint32_t bits;
+	uint64_t offset;
+};
+
+inline bool operator<(const PolarCacheEntry &a, const PolarCacheEntry &b)
+{
+	if (a.order != b.order)
+		return a.order < b.order;
+	if (a.numerator != b.numerator)
+		return a.numerator < b.numerator;
+	return a.denominator < b.denominator;
+}
+
+struct PolarSequence
+{
+	int order;
+	int numerator;
+	int denominator;
+	int bits;
+	std::vector<int32_t> sequence;
+};
+
+inline bool operator<(const PolarSequence &a, const PolarSequence &b)
+{
+	if (a.order != b.order)
+		return a.order < b.order;
+	if (a.numerator != b.numerator)
+		return a.numerator < b.numerator;
+	return a.denominator < b.denominator;
+}
+
+inline bool polar_cache_write(const char *path, std::vector<PolarSequence> sequences)
+{
+	std::sort(sequences.begin(), sequences.end());
+	PolarCacheHeader header;
+	std::memcpy(header.magic, polar_cache_magic, sizeof(header.magic));
+	header.version = polar_cache_version;
+	header.count = sequences.size();
+	std::vector<PolarCacheEntry> entries(sequences.size());
+	uint64_t offset = sizeof(header) + entries.size() * sizeof(PolarCacheEntry);
+	for (size_t i = 0; i < sequences.size(); ++i) {
+		entries[i] = PolarCacheEntry { uint32_t(sequences[i].order), uint32_t(sequences[i].numerator), uint32_t(sequences[i].denominator), uint32_t(sequences[i].bits), offset };
+		offset += sequences[i].sequence.size() * sizeof(int32_t);
+	}
+	std::string temp = std::string(path) + ".tmp";
+	FILE *file = std::fopen(temp.c_str(), "wb");
+	if (!file)
+		return false;
+	bool okay = std::fwrite(&header, sizeof(header), 1, file) == 1;
+	okay = okay && std::fwrite(entries.data(), sizeof(PolarCacheEntry), entries.size(), file) == entries.size();
+	for (auto &seq: sequences)
+		okay = okay && std::fwrite(seq.sequence.data(), sizeof(int32_t), seq.sequence.size(), file) == seq.sequence.size();
+	okay = !std::fclose(file) && okay;
+	if (okay)
+		okay = !std::rename(temp.c_str(), path);
+	if (!okay)
+		std::remove(temp.c_str());
+	return okay;
+}
+
+struct PolarCache
+{
+	void *data = MAP_FAILED;
+	size_t size = 0;
+	const PolarCacheHeader *header = nullptr;
+	const PolarCacheEntry *entries = nullptr;
+	PolarCache() = default;
+	PolarCache(const PolarCache &) = delete;
+	PolarCache &operator=(const PolarCache &) = delete;
+	~PolarCache()
+	{
+		close();
+	}
+	void close()
+	{
+		if (data != MAP_FAILED)
+			munmap(data, size);
+		data = MAP_FAILED;
+		size = 0;
+		header = nullptr;
+		entries = nullptr;
+	}
+	bool open(const char *path)
+	{
+		close();
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) || size_t(st.st_size) < sizeof(PolarCacheHeader)) {
+			::close(fd);
+			return false;
+		}
+		size = st.st_size;
+		data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (data == MAP_FAILED)
+			return false;
+		header = reinterpret_cast<const PolarCacheHeader *>(data);
+		entries = reinterpret_cast<const PolarCacheEntry *>(header + 1);
+		uint64_t table = sizeof(PolarCacheHeader) + uint64_t(header->count) * sizeof(PolarCacheEntry);
+		if (std::memcmp(header->magic, polar_cache_magic, sizeof(header->magic)) || header->version != polar_cache_version || table > size) {
+			close();
+			return false;
+		}
+		for (uint32_t i = 0; i < header->count; ++i) {
+			if (entries[i].order > 30 || entries[i].offset % sizeof(int32_t) || entries[i].offset < table || entries[i].offset > size || (sizeof(int32_t) << entries[i].order) > size - entries[i].offset || (i && !(entries[i - 1] < entries[i]))) {
+				close();
+				return false;
+			}
+		}
+		return true;
+	}
+	int count() const
+	{
+		return header ? header->count : 0;
+	}
+	const int32_t *sequence(const PolarCacheEntry &entry) const
+	{
+		return reinterpret_cast<const int32_t *>(reinterpret_cast<const char *>(data) + entry.offset);
+	}
+	const PolarCacheEntry *find(int order, int numerator, int denominator) const
+	{
+		PolarCacheEntry key { uint32_t(order), uint32_t(numerator), uint32_t(denominator), 0, 0 };
+		auto end = entries + count();
+		auto it = std::lower_bound(entries, end, key);
+		if (it == end || key < *it)
+			return nullptr;
+		return it;
+	}
+};
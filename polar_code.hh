@@ -0,0 +1,698 @@
+/*
+Polar code bit reliability sequence construction
+
+Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
+*/
+
+#pragma once
+
+#include <cassert>
+#include <bit>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cmath>
+#include "two_int.hh"
+#include "two_int_batch.hh"
+#include "two_int_sort.hh"
+#include "polar_cache.hh"
+
+constexpr int significant(int value)
+{
+	return value ? std::bit_width(unsigned(value)) - 1 : 0;
+}
+
+template <typename FUNC>
+void parallel_for(int count, int threads, FUNC func)
+{
+	std::atomic<int> next(0);
+	std::vector<std::thread> pool;
+	for (int t = 0; t < threads; ++t)
+		pool.emplace_back([&next, count, func]() {
+			for (int i; (i = next++) < count;)
+				func(i);
+		});
+	for (auto &thread: pool)
+		thread.join();
+}
+
+template <typename COMPARE>
+void parallel_sort(int *sequence, int length, int threads, COMPARE compare)
+{
+	int chunks = 1;
+	while (chunks < threads && chunks < length)
+		chunks *= 2;
+	int size = (length + chunks - 1) / chunks;
+	parallel_for(chunks, threads, [=](int j) {
+		int begin = std::min(j * size, length), end = std::min(begin + size, length);
+		std::sort(sequence + begin, sequence + end, compare);
+	});
+	for (; size < length; size *= 2) {
+		int pairs = (length + 2 * size - 1) / (2 * size);
+		parallel_for(pairs, threads, [=](int j) {
+			int begin = j * 2 * size, middle = std::min(begin + size, length), end = std::min(begin + 2 * size, length);
+			std::inplace_merge(sequence + begin, sequence + middle, sequence + end, compare);
+		});
+	}
+}
+
+inline int subtree_size(int length, int threads)
+{
+	int tasks = 1;
+	while (tasks < 4 * threads && tasks < length)
+		tasks *= 2;
+	return length / tasks;
+}
+
+template <typename TYPE, int ORDER>
+struct PolarCodeConst0
+{
+	static const int LENGTH = 1 << ORDER;
+	TYPE prob[LENGTH];
+	constexpr void compute(TYPE pe, int i, int h)
+	{
+		if (h) {
+			TYPE sq = sqrhi(pe, 1);
+			compute((pe << 1) - sq, i, h/2);
+			compute(sq, i+h, h/2);
+		} else {
+			prob[i] = pe;
+		}
+	}
+	constexpr void split(TYPE pe, int i, int h, int size)
+	{
+		if (2 * h > size) {
+			TYPE sq = sqrhi(pe, 1);
+			split((pe << 1) - sq, i, h/2, size);
+			split(sq, i+h, h/2, size);
+		} else {
+			prob[i] = pe;
+		}
+	}
+	void compute(TYPE pe, int threads)
+	{
+		int size = subtree_size(LENGTH, threads);
+		split(pe, 0, LENGTH / 2, size);
+		parallel_for(LENGTH / size, threads, [this, size](int j) {
+			compute(prob[j * size], j * size, size / 2);
+		});
+	}
+	constexpr bool before(int a, int b) const
+	{
+		return prob[a] > prob[b] || (prob[a] == prob[b] && a < b);
+	}
+	constexpr void operator()(int *sequence, int numerator = 1, int denominator = 2, int threads = 1)
+	{
+		assert(numerator <= denominator);
+		int bits = sizeof(TYPE) * 8;
+		int shift = significant(numerator);
+		TYPE erasure_probability = TYPE(numerator) << bits - 1 - shift;
+		erasure_probability /= denominator;
+		erasure_probability <<= shift;
+		if (threads > 1)
+			compute(erasure_probability, threads);
+		else
+			compute(erasure_probability, 0, LENGTH / 2);
+		for (int i = 0; i < LENGTH; ++i)
+			sequence[i] = i;
+		if (threads > 1)
+			parallel_sort(sequence, LENGTH, threads, [this](int a, int b){ return before(a, b); });
+		else if (std::is_constant_evaluated())
+			std::sort(sequence, sequence+LENGTH, [this](int a, int b){ return before(a, b); });
+		else
+			sort_by_key(sequence, LENGTH, prob, true);
+	}
+};
+
+template <int ORDER>
+struct PolarCodeConst0<double, ORDER>
+{
+	typedef double TYPE;
+	static const int LENGTH = 1 << ORDER;
+	TYPE prob[LENGTH];
+	constexpr void compute(TYPE pe, int i, int h)
+	{
+		if (h) {
+			compute(2.0 * pe - pe * pe, i, h/2);
+			compute(pe * pe, i+h, h/2);
+		} else {
+			prob[i] = pe;
+		}
+	}
+	constexpr void split(TYPE pe, int i, int h, int size)
+	{
+		if (2 * h > size) {
+			split(2.0 * pe - pe * pe, i, h/2, size);
+			split(pe * pe, i+h, h/2, size);
+		} else {
+			prob[i] = pe;
+		}
+	}
+	void compute(TYPE pe, int threads)
+	{
+		int size = subtree_size(LENGTH, threads);
+		split(pe, 0, LENGTH / 2, size);
+		parallel_for(LENGTH / size, threads, [this, size](int j) {
+			compute(prob[j * size], j * size, size / 2);
+		});
+	}
+	constexpr bool before(int a, int b) const
+	{
+		return prob[a] > prob[b] || (prob[a] == prob[b] && a < b);
+	}
+	constexpr void operator()(int *sequence, int numerator = 1, int denominator = 2, int threads = 1)
+	{
+		assert(numerator <= denominator);
+		TYPE erasure_probability = TYPE(numerator);
+		erasure_probability /= TYPE(denominator);
+		if (threads > 1)
+			compute(erasure_probability, threads);
+		else
+			compute(erasure_probability, 0, LENGTH / 2);
+		for (int i = 0; i < LENGTH; ++i)
+			sequence[i] = i;
+		if (threads > 1)
+			parallel_sort(sequence, LENGTH, threads, [this](int a, int b){ return before(a, b); });
+		else
+			std::sort(sequence, sequence+LENGTH, [this](int a, int b){ return before(a, b); });
+	}
+};
+
+template <typename TYPE, int ORDER>
+struct PolarCodeConst1
+{
+	static const int LENGTH = 1 << ORDER;
+	static const int LANES = 16;
+	TYPE prob[LENGTH];
+	void batch(int i, int h)
+	{
+		TwoIntBatch<TYPE, LANES> pe;
+		for (int l = 0; l < LANES; ++l)
+			pe.insert(l, prob[i + 2 * h * l]);
+		TwoIntBatch<TYPE, LANES> sq = mulhi(pe, pe, 1);
+		pe = (pe << 1) - sq;
+		for (int l = 0; l < LANES; ++l) {
+			prob[i + 2 * h * l] = pe.extract(l);
+			prob[i + 2 * h * l + h] = sq.extract(l);
+		}
+	}
+	constexpr void levels(int begin, int end, int last)
+	{
+		for (int h = (end - begin) / 2; h >= last; h /= 2) {
+			int i = begin;
+			if (!std::is_constant_evaluated())
+				for (; i + 2 * h * (LANES - 1) < end; i += 2 * h * LANES)
+					batch(i, h);
+			for (; i < end; i += 2 * h) {
+				prob[i+h] = sqrhi(prob[i], 1);
+				prob[i] <<= 1;
+				prob[i] -= prob[i+h];
+			}
+		}
+	}
+	constexpr void compute(TYPE pe)
+	{
+		prob[0] = pe;
+		levels(0, LENGTH, 1);
+	}
+	void compute(TYPE pe, int threads)
+	{
+		int size = subtree_size(LENGTH, threads);
+		prob[0] = pe;
+		levels(0, LENGTH, size);
+		parallel_for(LENGTH / size, threads, [this, size](int j) {
+			levels(j * size, (j + 1) * size, 1);
+		});
+	}
+	constexpr bool before(int a, int b) const
+	{
+		return prob[a] > prob[b] || (prob[a] == prob[b] && a < b);
+	}
+	constexpr void operator()(int *sequence, int numerator = 1, int denominator = 2, int threads = 1)
+	{
+		assert(numerator <= denominator);
+		int bits = sizeof(TYPE) * 8;
+		int shift = significant(numerator);
+		TYPE erasure_probability = TYPE(numerator) << bits - 1 - shift;
+		erasure_probability /= denominator;
+		erasure_probability <<= shift;
+		if (threads > 1)
+			compute(erasure_probability, threads);
+		else
+			compute(erasure_probability);
+		for (int i = 0; i < LENGTH; ++i)
+			sequence[i] = i;
+		if (threads > 1)
+			parallel_sort(sequence, LENGTH, threads, [this](int a, int b){ return before(a, b); });
+		else if (std::is_constant_evaluated())
+			std::sort(sequence, sequence+LENGTH, [this](int a, int b){ return before(a, b); });
+		else
+			sort_by_key(sequence, LENGTH, prob, true);
+	}
+};
+
+template <int ORDER>
+struct PolarCodeConst1<double, ORDER>
+{
+	typedef double TYPE;
+	static const int LENGTH = 1 << ORDER;
+	TYPE prob[LENGTH];
+	constexpr void levels(int begin, int end, int last)
+	{
+		for (int h = (end - begin) / 2; h >= last; h /= 2) {
+			for (int i = begin; i < end; i += 2 * h) {
+				TYPE sq = prob[i] * prob[i];
+				prob[i] = 2.0 * prob[i] - sq;
+				prob[i+h] = sq;
+			}
+		}
+	}
+	constexpr void compute(TYPE pe)
+	{
+		prob[0] = pe;
+		levels(0, LENGTH, 1);
+	}
+	void compute(TYPE pe, int threads)
+	{
+		int size = subtree_size(LENGTH, threads);
+		prob[0] = pe;
+		levels(0, LENGTH, size);
+		parallel_for(LENGTH / size, threads, [this, size](int j) {
+			levels(j * size, (j + 1) * size, 1);
+		});
+	}
+	constexpr bool before(int a, int b) const
+	{
+		return prob[a] > prob[b] || (prob[a] == prob[b] && a < b);
+	}
+	constexpr void operator()(int *sequence, int numerator = 1, int denominator = 2, int threads = 1)
+	{
+		assert(numerator <= denominator);
+		TYPE erasure_probability = TYPE(numerator);
+		erasure_probability /= TYPE(denominator);
+		if (threads > 1)
+			compute(erasure_probability, threads);
+		else
+			compute(erasure_probability);
+		for (int i = 0; i < LENGTH; ++i)
+			sequence[i] = i;
+		if (threads > 1)
+			parallel_sort(sequence, LENGTH, threads, [this](int a, int b){ return before(a, b); });
+		else
+			std::sort(sequence, sequence+LENGTH, [this](int a, int b){ return before(a, b); });
+	}
+};
+
+template <typename TYPE, int ORDER>
+struct PolarCodeHybrid
+{
+	static const int LENGTH = 1 << ORDER;
+	static const int BITS = sizeof(TYPE) * 8;
+	static constexpr long ZERO = -(1L << 40);
+	struct Approx
+	{
+		double mantissa;
+		long exponent;
+		bool complement;
+	};
+	Approx approx[LENGTH];
+	TYPE prob[LENGTH];
+	int exact_leaves = 0;
+	static Approx normalize(double mantissa, long exponent, bool complement)
+	{
+		if (mantissa == 0)
+			return Approx { 0, ZERO, complement };
+		int e;
+		mantissa = std::frexp(mantissa, &e);
+		return Approx { mantissa, exponent + e, complement };
+	}
+	static double value(Approx a)
+	{
+		return a.exponent < -1100 ? 0 : std::ldexp(a.mantissa, a.exponent);
+	}
+	static double scale(long exponent)
+	{
+		return std::ldexp(1.0, std::max(exponent, -1100L));
+	}
+	void butterfly(int i, int h)
+	{
+		Approx x = approx[i];
+		Approx sq = normalize(x.mantissa * x.mantissa, 2 * x.exponent, x.complement);
+		double v = value(x);
+		Approx other = normalize(x.mantissa * (2 - v), x.exponent, x.complement);
+		if (value(other) > 0.5)
+			other = normalize((1 - v) * (1 - v), 0, !x.complement);
+		approx[i] = x.complement ? sq : other;
+		approx[i+h] = x.complement ? other : sq;
+	}
+	bool before(int a, int b) const
+	{
+		const Approx &x = approx[a], &y = approx[b];
+		if (x.complement != y.complement)
+			return x.complement;
+		if (x.exponent != y.exponent || x.mantissa != y.mantissa)
+			return (x.exponent < y.exponent || (x.exponent == y.exponent && x.mantissa < y.mantissa)) == x.complement;
+		return a < b;
+	}
+	bool ambiguous(int a, int b) const
+	{
+		const Approx &x = approx[a], &y = approx[b];
+		double relative = std::ldexp(1.0, ORDER + 4 - 53);
+		long absolute = ORDER + 5 - BITS;
+		if (x.complement != y.complement)
+			return value(x) + value(y) >= 1 - relative - scale(absolute);
+		const Approx &big = x.complement ? y : x, &small = x.complement ? x : y;
+		if (big.exponent <= absolute + 1)
+			return true;
+		double diff = big.mantissa - small.mantissa * scale(small.exponent - big.exponent);
+		return diff <= relative * big.mantissa + scale(absolute - big.exponent);
+	}
+	void compute(TYPE pe, int i, int h, int size, const int *marks)
+	{
+		if (marks[i + std::max(2 * h, 1)] == marks[i])
+			return;
+		if (2 * h > size) {
+			TYPE sq = sqrhi(pe, 1);
+			compute((pe << 1) - sq, i, h/2, size, marks);
+			compute(sq, i+h, h/2, size, marks);
+		} else {
+			prob[i] = pe;
+		}
+	}
+	void operator()(int *sequence, int numerator = 1, int denominator = 2, int threads = 1)
+	{
+		assert(numerator <= denominator);
+		assert(threads >= 1);
+		int shift = significant(numerator);
+		TYPE erasure_probability = TYPE(numerator) << BITS - 1 - shift;
+		erasure_probability /= denominator;
+		erasure_probability <<= shift;
+		bool complement = 2 * numerator > denominator;
+		approx[0] = normalize(double(complement ? denominator - numerator : numerator) / denominator, 0, complement);
+		for (int h = LENGTH / 2; h; h /= 2)
+			for (int i = 0; i < LENGTH; i += 2 * h)
+				butterfly(i, h);
+		for (int i = 0; i < LENGTH; ++i)
+			sequence[i] = i;
+		std::sort(sequence, sequence+LENGTH, [this](int a, int b){ return before(a, b); });
+		std::vector<std::pair<int, int>> runs;
+		for (int begin = 0, end = 1; begin < LENGTH; begin = end++) {
+			while (end < LENGTH && ambiguous(sequence[end-1], sequence[end]))
+				++end;
+			if (end - begin > 1)
+				runs.push_back(std::make_pair(begin, end));
+		}
+		std::vector<int> marks(LENGTH + 1);
+		for (auto &run: runs)
+			for (int i = run.first; i < run.second; ++i)
+				marks[sequence[i] + 1] = 1;
+		for (int i = 0; i < LENGTH; ++i)
+			marks[i + 1] += marks[i];
+		int size = subtree_size(LENGTH, threads);
+		compute(erasure_probability, 0, LENGTH / 2, size, marks.data());
+		parallel_for(LENGTH / size, threads, [this, size, &marks](int j) {
+			compute(prob[j * size], j * size, size / 2, 0, marks.data());
+		});
+		parallel_for(runs.size(), threads, [this, sequence, &runs](int r) {
+			int *run = sequence + runs[r].first, length = runs[r].second - runs[r].first;
+			std::sort(run, run + length);
+			std::vector<TYPE> key(length);
+			std::vector<int> order(length);
+			for (int i = 0; i < length; ++i) {
+				key[i] = prob[run[i]];
+				order[i] = i;
+			}
+			sort_by_key(order.data(), length, key.data(), true);
+			for (int i = 0; i < length; ++i)
+				order[i] = run[order[i]];
+			std::copy(order.begin(), order.end(), run);
+		});
+		exact_leaves = 0;
+		for (auto &run: runs)
+			exact_leaves += run.second - run.first;
+	}
+};
+
+template <typename TYPE>
+struct PolarCodeRuntime
+{
+	static const int LANES = 16;
+	int order, length, block;
+	std::vector<SortRecord> records;
+	PolarCodeRuntime(int order, int block_order = 12) : order(order), length(1 << order), block(1 << std::min(order, block_order)) {}
+	void batch(TYPE *prob, int i, int h)
+	{
+		TwoIntBatch<TYPE, LANES> pe;
+		for (int l = 0; l < LANES; ++l)
+			pe.insert(l, prob[i + 2 * h * l]);
+		TwoIntBatch<TYPE, LANES> sq = mulhi(pe, pe, 1);
+		pe = (pe << 1) - sq;
+		for (int l = 0; l < LANES; ++l) {
+			prob[i + 2 * h * l] = pe.extract(l);
+			prob[i + 2 * h * l + h] = sq.extract(l);
+		}
+	}
+	TYPE root(TYPE pe, int j)
+	{
+		for (int h = length / 2; h >= block; h /= 2) {
+			TYPE sq = sqrhi(pe, 1);
+			pe = j * block & h ? sq : (pe << 1) - sq;
+		}
+		return pe;
+	}
+	void compute(TYPE pe, int i, int h, const std::vector<int> &tied, std::vector<TYPE> &exact)
+	{
+		auto first = std::lower_bound(tied.begin(), tied.end(), i);
+		if (first == tied.end() || *first >= i + std::max(2 * h, 1))
+			return;
+		if (h) {
+			TYPE sq = sqrhi(pe, 1);
+			compute((pe << 1) - sq, i, h/2, tied, exact);
+			compute(sq, i+h, h/2, tied, exact);
+		} else {
+			exact[first - tied.begin()] = pe;
+		}
+	}
+	void compute(TYPE *prob, TYPE pe, int j)
+	{
+		prob[0] = root(pe, j);
+		for (int h = block / 2; h; h /= 2) {
+			int i = 0;
+			for (; i + 2 * h * (LANES - 1) < block; i += 2 * h * LANES)
+				batch(prob, i, h);
+			for (; i < block; i += 2 * h) {
+				prob[i+h] = sqrhi(prob[i], 1);
+				prob[i] <<= 1;
+				prob[i] -= prob[i+h];
+			}
+		}
+	}
+	template <typename FUNC>
+	void stream(TYPE pe, const std::vector<int> &blocks, int threads, FUNC func)
+	{
+		assert(threads >= 1);
+		std::vector<std::vector<TYPE>> arena(threads, std::vector<TYPE>(block));
+		std::atomic<int> next(0);
+		parallel_for(threads, threads, [&](int t) {
+			TYPE *prob = arena[t].data();
+			for (int n; (n = next++) < int(blocks.size());) {
+				compute(prob, pe, blocks[n]);
+				func(prob, blocks[n]);
+			}
+		});
+	}
+	SortRecord record(const TYPE &pe, int index)
+	{
+		TYPE one = TYPE(1) << sizeof(TYPE) * 8 - 1;
+		if (pe < one >> 1)
+			return sort_record(pe, index, true);
+		return sort_record(one - pe, index);
+	}
+	void operator()(int *sequence, int numerator = 1, int denominator = 2, int threads = 1)
+	{
+		assert(numerator <= denominator);
+		int bits = sizeof(TYPE) * 8;
+		int shift = significant(numerator);
+		TYPE erasure_probability = TYPE(numerator) << bits - 1 - shift;
+		erasure_probability /= denominator;
+		erasure_probability <<= shift;
+		std::vector<int> blocks(length / block);
+		for (int j = 0; j < length / block; ++j)
+			blocks[j] = j;
+		records.resize(length);
+		stream(erasure_probability, blocks, threads, [this](const TYPE *prob, int j) {
+			for (int i = 0; i < block; ++i)
+				records[j * block + i] = record(prob[i], j * block + i);
+		});
+		radix_sort(records.data(), length);
+		for (int i = 0; i < length; ++i)
+			sequence[i] = records[i].index;
+		std::vector<std::pair<int, int>> ties;
+		for (int begin = 0, end = 1; begin < length; begin = end++) {
+			while (end < length && same_key(records[end], records[begin]))
+				++end;
+			if (end - begin > 1 && std::min(records[begin].exponent, ~records[begin].exponent) > 64)
+				ties.push_back(std::make_pair(begin, end));
+		}
+		records.clear();
+		records.shrink_to_fit();
+		if (ties.empty())
+			return;
+		std::vector<int> tied;
+		for (auto &tie: ties)
+			tied.insert(tied.end(), sequence + tie.first, sequence + tie.second);
+		std::sort(tied.begin(), tied.end());
+		std::vector<TYPE> exact(tied.size());
+		blocks.clear();
+		for (int index: tied)
+			if (blocks.empty() || blocks.back() != index / block)
+				blocks.push_back(index / block);
+		parallel_for(blocks.size(), threads, [this, erasure_probability, &blocks, &tied, &exact](int n) {
+			compute(root(erasure_probability, blocks[n]), blocks[n] * block, block / 2, tied, exact);
+		});
+		parallel_for(ties.size(), threads, [sequence, &ties, &tied, &exact](int t) {
+			int *tie = sequence + ties[t].first, count = ties[t].second - ties[t].first;
+			std::sort(tie, tie + count);
+			std::vector<TYPE> key(count);
+			std::vector<int> order(count);
+			for (int i = 0; i < count; ++i) {
+				key[i] = exact[std::lower_bound(tied.begin(), tied.end(), tie[i]) - tied.begin()];
+				order[i] = i;
+			}
+			sort_by_key(order.data(), count, key.data(), true);
+			for (int i = 0; i < count; ++i)
+				order[i] = tie[order[i]];
+			std::copy(order.begin(), order.end(), tie);
+		});
+	}
+};
+
+template <typename TYPE>
+TYPE erasure_probability(int numerator, int denominator)
+{
+	int bits = sizeof(TYPE) * 8;
+	int shift = significant(numerator);
+	TYPE pe = TYPE(numerator) << bits - 1 - shift;
+	pe /= denominator;
+	pe <<= shift;
+	return pe;
+}
+
+template <>
+inline double erasure_probability<double>(int numerator, int denominator)
+{
+	return double(numerator) / double(denominator);
+}
+
+template <typename TYPE>
+void polar_extend(TYPE *next, const TYPE *prob, int begin, int end)
+{
+	const int LANES = 16;
+	int j = begin;
+	for (; j + LANES <= end; j += LANES) {
+		TwoIntBatch<TYPE, LANES> pe;
+		for (int l = 0; l < LANES; ++l)
+			pe.insert(l, prob[j + l]);
+		TwoIntBatch<TYPE, LANES> sq = mulhi(pe, pe, 1);
+		pe = (pe << 1) - sq;
+		for (int l = 0; l < LANES; ++l) {
+			next[2 * (j + l)] = pe.extract(l);
+			next[2 * (j + l) + 1] = sq.extract(l);
+		}
+	}
+	for (; j < end; ++j) {
+		next[2 * j + 1] = sqrhi(prob[j], 1);
+		next[2 * j] = prob[j] << 1;
+		next[2 * j] -= next[2 * j + 1];
+	}
+}
+
+template <>
+inline void polar_extend<double>(double *next, const double *prob, int begin, int end)
+{
+	for (int j = begin; j < end; ++j) {
+		double sq = prob[j] * prob[j];
+		next[2 * j] = 2.0 * prob[j] - sq;
+		next[2 * j + 1] = sq;
+	}
+}
+
+template <typename TYPE>
+struct PolarCodeIncremental
+{
+	int order = 0;
+	std::vector<TYPE> prob;
+	PolarCodeIncremental(int numerator = 1, int denominator = 2) : prob(1, erasure_probability<TYPE>(numerator, denominator)) {}
+	void extend(int levels = 1, int threads = 1)
+	{
+		assert(threads >= 1);
+		for (int level = 0; level < levels; ++level, ++order) {
+			int length = prob.size();
+			std::vector<TYPE> next(2 * length);
+			int chunk = (length + threads - 1) / threads;
+			if (threads > 1 && chunk >= 16) {
+				parallel_for(threads, threads, [this, &next, length, chunk](int t) {
+					int begin = std::min(t * chunk, length), end = std::min(begin + chunk, length);
+					polar_extend(next.data(), prob.data(), begin, end);
+				});
+			} else {
+				polar_extend(next.data(), prob.data(), 0, length);
+			}
+			prob.swap(next);
+		}
+	}
+	void operator()(int *sequence) const
+	{
+		int length = prob.size();
+		for (int i = 0; i < length; ++i)
+			sequence[i] = i;
+		sort_by_key(sequence, length, prob.data(), true);
+	}
+};
+
+template <typename TYPE>
+std::vector<PolarSequence> polar_batch(std::vector<PolarSequence> points, int threads = 1, int shared_order = 16)
+{
+	std::sort(points.begin(), points.end(), [](const PolarSequence &a, const PolarSequence &b) {
+		if (a.numerator != b.numerator)
+			return a.numerator < b.numerator;
+		if (a.denominator != b.denominator)
+			return a.denominator < b.denominator;
+		return a.order < b.order;
+	});
+	for (size_t begin = 0, end = 1; begin < points.size(); begin = end++) {
+		while (end < points.size() && points[end].numerator == points[begin].numerator && points[end].denominator == points[begin].denominator)
+			++end;
+		int top = points[end-1].order;
+		if constexpr (!std::is_floating_point<TYPE>::value) {
+			if (top > shared_order) {
+				for (size_t n = begin; n < end; ++n) {
+					PolarCodeRuntime<TYPE> engine(points[n].order);
+					points[n].sequence.resize(1 << points[n].order);
+					engine(points[n].sequence.data(), points[n].numerator, points[n].denominator, threads);
+					points[n].bits = sizeof(TYPE) * 8;
+				}
+				continue;
+			}
+		}
+		PolarCodeIncremental<TYPE> tree(points[begin].numerator, points[begin].denominator);
+		for (size_t n = begin; n < end; ++n) {
+			tree.extend(points[n].order - tree.order, threads);
+			points[n].sequence.resize(1 << points[n].order);
+			tree(points[n].sequence.data());
+			points[n].bits = sizeof(TYPE) * 8;
+		}
+	}
+	return points;
+}
+
+template <typename TYPE, int ORDER, template <typename, int> class ENGINE = PolarCodeConst1>
+constexpr std::array<int, 1 << ORDER> polar_sequence(int numerator = 1, int denominator = 2)
+{
+	ENGINE<TYPE, ORDER> freeze;
+	std::array<int, 1 << ORDER> sequence;
+	freeze(sequence.data(), numerator, denominator);
+	return sequence;
+}
@@ -5,253 +5,776 @@ Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
 */
 
 #include <random>
-#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <sstream>
+#include <cstddef>
+#include <cstring>
+#include <cstdlib>
 #include <algorithm>
-#include <functional>
 #include <iostream>
 #include <iomanip>
 #include "two_int.hh"
+#include "flat_int.hh"
+#include "two_int_batch.hh"
+#include "two_int_sort.hh"
+#include "two_int_chars.hh"
+#include "two_int_montgomery.hh"
+#include "two_int_divider.hh"
+#include "polar_code.hh"
+
+typedef TwoInt<TwoInt<TwoInt<uint8_t>>> const64;
+static_assert(const64(0x0123456789abcdef) * const64(0xfedcba9876543210) == const64(0x0123456789abcdefULL * 0xfedcba9876543210ULL));
+static_assert(const64(0xfedcba9876543210) / const64(0x12345) == const64(0xfedcba9876543210ULL / 0x12345));
+static_assert(const64(0xfedcba9876543210) % const64(0x12345) == const64(0xfedcba9876543210ULL % 0x12345));
+#ifdef __SIZEOF_INT128__
+typedef TwoInt<TwoInt<uint64_t>> const256;
+static_assert(mul(const256::max(), const256::max()).upper == const256::max() - const256(1));
+static_assert(sqr(const256::max()) == mul(const256::max(), const256::max()));
+static_assert(div(const256::max(), const256(1) << 200).lower == const256::max() >> 200);
+static_assert(const256::max() / uint64_t(3) * 3 == const256::max());
+#endif
+
+struct Xoshiro
+{
+	uint64_t s[4];
+	void seed(uint64_t seed, uint64_t stream)
+	{
+		uint64_t x = seed ^ stream * 0xd1342543de82ef95;
+		for (auto &v: s) {
+			uint64_t z = (x += 0x9e3779b97f4a7c15);
+			z = (z ^ z >> 30) * 0xbf58476d1ce4e5b9;
+			z = (z ^ z >> 27) * 0x94d049bb133111eb;
+			v = z ^ z >> 31;
+		}
+	}
+	uint64_t operator()()
+	{
+		uint64_t result = std::rotl(s[1] * 5, 7) * 9, t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = std::rotl(s[3], 45);
+		return result;
+	}
+};
 
 template <typename TYPE>
-std::ostream &operator<<(std::ostream &os, const TwoInt<TYPE> a)
+TYPE random_value(Xoshiro &rand)
 {
-	return os << a.upper << a.lower;
+	std::array<uint64_t, sizeof(TYPE) / 8> limb;
+	for (auto &l: limb)
+		l = rand();
+	return std::bit_cast<TYPE>(limb);
 }
 
-template <>
-std::ostream &operator<<<uint8_t>(std::ostream &os, const TwoInt<uint8_t> a)
+inline uint64_t nonzero(uint64_t value)
 {
-	return os << std::hex
-		<< std::setw(2) << std::setfill('0') << (unsigned)a.upper
-		<< std::setw(2) << std::setfill('0') << (unsigned)a.lower;
+	return value ? value : 1;
 }
 
-template <>
-std::ostream &operator<<<uint16_t>(std::ostream &os, const TwoInt<uint16_t> a)
+struct Case
+{
+	std::string message;
+	template <typename... ARGS>
+	bool fail(const char *expression, int line, const char *names, const ARGS &... values)
+	{
+		std::ostringstream os;
+		os << "line " << line << ": " << expression;
+		if (sizeof...(values))
+			os << "\n  " << names << " =" << std::hex;
+		((os << "\n    " << values), ...);
+		message = os.str();
+		return false;
+	}
+};
+
+#define CHECK(cond, ...) do { if (!(cond)) return c.fail(#cond, __LINE__, #__VA_ARGS__ __VA_OPT__(,) __VA_ARGS__); } while (0)
+
+struct Suite
 {
-	return os << std::hex
-		<< std::setw(4) << std::setfill('0') << a.upper
-		<< std::setw(4) << std::setfill('0') << a.lower;
+	const char *name;
+	bool exhaustive;
+	uint64_t items;
+	uint64_t checks;
+	bool (*check)(Case &c, uint64_t item, Xoshiro &rand);
+};
+
+const int polar_rates[][2] = { { 0, 1 }, { 1, 100 }, { 1, 2 }, { 2, 3 }, { 7, 8 }, { 99, 100 }, { 1, 1 } };
+
+template <typename ENGINE>
+std::vector<int> polar_run(int numerator, int denominator, int threads)
+{
+	auto freeze = std::make_unique<ENGINE>();
+	std::vector<int> sequence(ENGINE::LENGTH);
+	(*freeze)(sequence.data(), numerator, denominator, threads);
+	return sequence;
 }
 
-template <>
-std::ostream &operator<<<uint32_t>(std::ostream &os, const TwoInt<uint32_t> a)
+template <int... ORDERS, typename FUNC>
+bool polar_order(int order, std::integer_sequence<int, ORDERS...>, FUNC func)
 {
-	return os << std::hex
-		<< std::setw(8) << std::setfill('0') << a.upper
-		<< std::setw(8) << std::setfill('0') << a.lower;
+	bool okay = true;
+	((order == ORDERS && (okay = func(std::integral_constant<int, ORDERS>()))), ...);
+	return okay;
 }
 
-int main()
+template <typename FUNC>
+bool polar_case(int width, int order, FUNC func)
 {
-	if (0) {
-		typedef TwoInt<uint8_t> u16;
-		uint16_t a = 0;
-		u16 b(0);
-		for (int i = 0; i < (1 << 20); ++i) {
-			++a;
-			++b;
-			assert(a == *reinterpret_cast<uint16_t *>(&b));
-		}
-		for (int i = 0; i < (1 << 20); ++i) {
-			--a;
-			--b;
-			assert(a == *reinterpret_cast<uint16_t *>(&b));
-		}
-	}
-	if (0) {
+#ifdef __SIZEOF_INT128__
+	typedef TwoInt<uint64_t> u128;
+#else
+	typedef TwoInt<TwoInt<uint32_t>> u128;
+#endif
+	typedef TwoInt<TwoInt<u128>> u512;
+	typedef TwoInt<TwoInt<TwoInt<u512>>> u4096;
+	return polar_order(order, std::make_integer_sequence<int, 15>(), [&func, width](auto ORDER) {
+		if (width == 0)
+			return func(std::type_identity<u128>(), ORDER);
+		if (width == 1)
+			return func(std::type_identity<u512>(), ORDER);
+		return func(std::type_identity<u4096>(), ORDER);
+	});
+}
+
+inline int polar_mismatch(const std::vector<int> &a, const std::vector<int> &b)
+{
+	return std::mismatch(a.begin(), a.end(), b.begin()).first - a.begin();
+}
+
+const Suite suites[] = {
+	{ "inc16", true, 65536, 3, [](Case &c, uint64_t i, Xoshiro &) {
 		typedef TwoInt<uint8_t> u16;
-		for (int i = 0; i < 65536; ++i)
-			for (int j = 0; j < 65536; ++j)
-				assert((i == j) == (u16(i) == u16(j)));
-		for (int i = 0; i < 65536; ++i)
-			for (int j = 0; j < 65536; ++j)
-				assert((i != j) == (u16(i) != u16(j)));
-		for (int i = 0; i < 65536; ++i)
-			for (int j = 0; j < 65536; ++j)
-				assert((i < j) == (u16(i) < u16(j)));
-		for (int i = 0; i < 65536; ++i)
-			for (int j = 0; j < 65536; ++j)
-				assert((i > j) == (u16(i) > u16(j)));
-		for (int i = 0; i < 65536; ++i)
-			for (int j = 0; j < 65536; ++j)
-				assert((i <= j) == (u16(i) <= u16(j)));
-		for (int i = 0; i < 65536; ++i)
-			for (int j = 0; j < 65536; ++j)
-				assert((i >= j) == (u16(i) >= u16(j)));
-	}
-	if (0) {
+		uint16_t a = i;
+		u16 b(i);
+		++a;
+		++b;
+		CHECK(a == std::bit_cast<uint16_t>(b), b);
+		a -= 2;
+		--b;
+		--b;
+		CHECK(a == std::bit_cast<uint16_t>(b), b);
+		CHECK(uint16_t(i + 7) == std::bit_cast<uint16_t>(b += u16(8)), b);
+		return true;
+	} },
+	{ "compare16", true, 65536, 65536 * 6, [](Case &c, uint64_t i, Xoshiro &) {
 		typedef TwoInt<uint8_t> u16;
-		for (int i = 0; i < 65536; ++i) {
-			for (int j = 0; j <= 16; ++j) {
-				uint16_t a = i >> j;
-				u16 b = u16(i) >> j;
-				assert(a == *reinterpret_cast<uint16_t *>(&b));
-			}
-		}
-		for (int i = 0; i < 65536; ++i) {
-			for (int j = 0; j <= 16; ++j) {
-				uint16_t a = i << j;
-				u16 b = u16(i) << j;
-				assert(a == *reinterpret_cast<uint16_t *>(&b));
-			}
+		for (uint64_t j = 0; j < 65536; ++j) {
+			u16 a(i), b(j);
+			CHECK((i == j) == (a == b) && (i != j) == (a != b), a, b);
+			CHECK((i < j) == (a < b) && (i > j) == (a > b), a, b);
+			CHECK((i <= j) == (a <= b) && (i >= j) == (a >= b), a, b);
 		}
-	}
-	if (0) {
+		return true;
+	} },
+	{ "shift16", true, 65536, 17 * 2, [](Case &c, uint64_t i, Xoshiro &) {
 		typedef TwoInt<uint8_t> u16;
-		for (int i = 0; i < 65536; ++i) {
-			for (int j = 0; j < 65536; ++j) {
-				uint16_t a = i + j;
-				u16 b = u16(i) + u16(j);
-				assert(a == *reinterpret_cast<uint16_t *>(&b));
-			}
+		for (int j = 0; j <= 16; ++j) {
+			u16 a = u16(i) >> j, b = u16(i) << j;
+			CHECK(uint16_t(i >> j) == std::bit_cast<uint16_t>(a), a, j);
+			CHECK(uint16_t(i << j) == std::bit_cast<uint16_t>(b), b, j);
 		}
-		for (int i = 0; i < 65536; ++i) {
-			for (int j = 0; j < 65536; ++j) {
-				uint16_t a = i - j;
-				u16 b = u16(i) - u16(j);
-				assert(a == *reinterpret_cast<uint16_t *>(&b));
-			}
+		return true;
+	} },
+	{ "addsub16", true, 65536, 65536 * 2, [](Case &c, uint64_t i, Xoshiro &) {
+		typedef TwoInt<uint8_t> u16;
+		for (uint64_t j = 0; j < 65536; ++j) {
+			u16 a = u16(i) + u16(j), b = u16(i) - u16(j);
+			CHECK(uint16_t(i + j) == std::bit_cast<uint16_t>(a), u16(i), u16(j), a);
+			CHECK(uint16_t(i - j) == std::bit_cast<uint16_t>(b), u16(i), u16(j), b);
 		}
-	}
-	if (0) {
+		return true;
+	} },
+	{ "mul16", true, 65536, 65536, [](Case &c, uint64_t i, Xoshiro &) {
 		typedef TwoInt<uint8_t> u16;
-		for (int i = 0; i < 65536; ++i) {
-			for (int j = 0; j < 65536; ++j) {
-				uint16_t a = i * j;
-				u16 b = u16(i) * u16(j);
-				assert(a == *reinterpret_cast<uint16_t *>(&b));
-			}
+		for (uint64_t j = 0; j < 65536; ++j) {
+			u16 a = u16(i) * u16(j);
+			CHECK(uint16_t(i * j) == std::bit_cast<uint16_t>(a), u16(i), u16(j), a);
 		}
-	}
-	if (0) {
+		return true;
+	} },
+	{ "mulwide16", true, 65536, 65536, [](Case &c, uint64_t i, Xoshiro &) {
 		typedef TwoInt<uint8_t> u16;
 		typedef TwoInt<u16> u32;
-		for (int i = 0; i < 65536; ++i) {
-			for (int j = 0; j < 65536; ++j) {
-				uint32_t a = i * j;
-				u32 b = mul(u16(i), u16(j));
-				assert(a == *reinterpret_cast<uint32_t *>(&b));
-			}
+		for (uint64_t j = 0; j < 65536; ++j) {
+			u32 a = mul(u16(i), u16(j));
+			CHECK(uint32_t(i * j) == std::bit_cast<uint32_t>(a), u16(i), u16(j), a);
 		}
-	}
-	if (0) {
+		return true;
+	} },
+	{ "mulwide17", true, 1 << 17, 1 << 17, [](Case &c, uint64_t i, Xoshiro &) {
 		typedef TwoInt<TwoInt<uint8_t>> u32;
 		typedef TwoInt<u32> u64;
-		for (int i = 0; i < (1 << 17); ++i) {
-			for (int j = 0; j < (1 << 17); ++j) {
-				uint64_t a = uint64_t(i) * uint64_t(j);
-				u64 b = mul(u32(i), u32(j));
-				assert(a == *reinterpret_cast<uint64_t *>(&b));
-			}
+		for (uint64_t j = 0; j < (1 << 17); ++j) {
+			u64 a = mul(u32(i), u32(j));
+			CHECK(i * j == std::bit_cast<uint64_t>(a), u32(i), u32(j), a);
 		}
-	}
-	if (0) {
+		return true;
+	} },
+	{ "addsub64", false, 1 << 20, 2, [](Case &c, uint64_t, Xoshiro &rand) {
 		typedef TwoInt<uint32_t> u64;
-		std::random_device rd;
-		std::default_random_engine engine(rd());
-		std::uniform_int_distribution<uint64_t> distribution(0, std::numeric_limits<uint64_t>::max());
-		auto rand = std::bind(distribution, engine);
-		for (int i = 0; i < (1 << 20); ++i) {
-			uint64_t x = rand(), y = rand();
-			uint64_t a = x + y;
-			u64 b = u64(x) + u64(y);
-			assert(a == *reinterpret_cast<uint64_t *>(&b));
-		}
-	}
-	if (0) {
+		uint64_t x = rand(), y = rand();
+		u64 a = u64(x) + u64(y), b = u64(x) - u64(y);
+		CHECK(x + y == std::bit_cast<uint64_t>(a), u64(x), u64(y), a);
+		CHECK(x - y == std::bit_cast<uint64_t>(b), u64(x), u64(y), b);
+		return true;
+	} },
+	{ "mul32", false, 1 << 20, 3, [](Case &c, uint64_t, Xoshiro &rand) {
+		typedef TwoInt<uint16_t> u32;
+		typedef TwoInt<u32> u64;
+		typedef TwoInt<TwoInt<uint8_t>> v32;
+		typedef TwoInt<v32> v64;
+		uint32_t x = rand(), y = rand();
+		u32 a = u32(x) * u32(y);
+		u64 b = mul(u32(x), u32(y));
+		v64 d = karatsuba(v32(x), v32(y));
+		CHECK(uint32_t(x * y) == std::bit_cast<uint32_t>(a), u32(x), u32(y), a);
+		CHECK(uint64_t(x) * y == std::bit_cast<uint64_t>(b), u32(x), u32(y), b);
+		CHECK(uint64_t(x) * y == std::bit_cast<uint64_t>(d), v32(x), v32(y), d);
+		return true;
+	} },
+	{ "muldiv64", false, 1 << 20, 5, [](Case &c, uint64_t i, Xoshiro &rand) {
 		typedef TwoInt<uint32_t> u64;
-		std::random_device rd;
-		std::default_random_engine engine(rd());
-		std::uniform_int_distribution<uint64_t> distribution(0, std::numeric_limits<uint64_t>::max());
-		auto rand = std::bind(distribution, engine);
-		for (int i = 0; i < (1 << 20); ++i) {
-			uint64_t x = rand(), y = rand();
-			uint64_t a = x - y;
-			u64 b = u64(x) - u64(y);
-			assert(a == *reinterpret_cast<uint64_t *>(&b));
+		uint64_t x = rand(), y = nonzero(rand() >> (i & 63));
+		u64 a = u64(x) * u64(y), b = u64(x) / u64(y), d = u64(x) % u64(y);
+		TwoInt<u64> e = div(u64(x), u64(y));
+		CHECK(x * y == std::bit_cast<uint64_t>(a), u64(x), u64(y), a);
+		CHECK(x / y == std::bit_cast<uint64_t>(b), u64(x), u64(y), b);
+		CHECK(x % y == std::bit_cast<uint64_t>(d), u64(x), u64(y), d);
+		CHECK(x / y == std::bit_cast<uint64_t>(e.lower) && x % y == std::bit_cast<uint64_t>(e.upper), u64(x), u64(y), e);
+		return true;
+	} },
+#ifdef __SIZEOF_INT128__
+	{ "native128", false, 1 << 20, 3, [](Case &c, uint64_t, Xoshiro &rand) {
+		typedef TwoInt<uint64_t> u128;
+		u128 x = random_value<u128>(rand), y = random_value<u128>(rand);
+		unsigned __int128 a = std::bit_cast<unsigned __int128>(x);
+		unsigned __int128 b = std::bit_cast<unsigned __int128>(y);
+		u128 f = x + y, g = x - y, h = x * y;
+		CHECK(a + b == std::bit_cast<unsigned __int128>(f), x, y, f);
+		CHECK(a - b == std::bit_cast<unsigned __int128>(g), x, y, g);
+		CHECK(a * b == std::bit_cast<unsigned __int128>(h), x, y, h);
+		return true;
+	} },
+	{ "nested128", false, 1 << 20, 4, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<uint64_t> u128;
+		typedef TwoInt<TwoInt<uint32_t>> w128;
+		u128 x = random_value<u128>(rand), y = random_value<u128>(rand);
+		y.upper >>= i & 63;
+		w128 a = std::bit_cast<w128>(x), b = std::bit_cast<w128>(y);
+		TwoInt<w128> d = mul(a, b);
+		CHECK(d == std::bit_cast<TwoInt<w128>>(mul(x, y)), x, y, d);
+		if (!y)
+			return true;
+		TwoInt<w128> e = div(a, b);
+		CHECK(e == std::bit_cast<TwoInt<w128>>(div(x, y)), x, y, e);
+		CHECK(e.lower == std::bit_cast<w128>(x / y) && e.upper == std::bit_cast<w128>(x % y), x, y, e);
+		return true;
+	} },
+#endif
+	{ "scalar64", false, 1 << 20, 5, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<uint16_t>> u64;
+		uint64_t x = rand(), y = rand() >> (i & 63) | 1;
+		u64 a = u64(x) + y, b = u64(x) - y, d = u64(x) * y, e = u64(x) / y;
+		CHECK(x + y == std::bit_cast<uint64_t>(a), u64(x), u64(y), a);
+		CHECK(x - y == std::bit_cast<uint64_t>(b), u64(x), u64(y), b);
+		CHECK(x * y == std::bit_cast<uint64_t>(d), u64(x), u64(y), d);
+		CHECK(x / y == std::bit_cast<uint64_t>(e), u64(x), u64(y), e);
+		CHECK(x % y == u64(x) % y, u64(x), u64(y));
+		return true;
+	} },
+#ifdef __SIZEOF_INT128__
+	{ "flat512", false, 1 << 16, 9, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<TwoInt<uint64_t>>> u512;
+		typedef FlatInt<512> f512;
+		f512 x = random_value<f512>(rand), y = random_value<f512>(rand);
+		for (int j = i % f512::LIMBS; j < f512::LIMBS; ++j)
+			y.limb[j] = 0;
+		u512 a = std::bit_cast<u512>(x), b = std::bit_cast<u512>(y);
+		CHECK(a + b == std::bit_cast<u512>(x + y), x, y);
+		CHECK(a - b == std::bit_cast<u512>(x - y), x, y);
+		CHECK(a * b == std::bit_cast<u512>(x * y), x, y);
+		CHECK(mul(a, b) == std::bit_cast<TwoInt<u512>>(mul(x, y)), x, y);
+		int s = rand() % 512;
+		CHECK((a << s) == std::bit_cast<u512>(x << s), x, s);
+		CHECK((a >> s) == std::bit_cast<u512>(x >> s), x, s);
+		CHECK((a < b) == (x < y) && (a == b) == (x == y), x, y);
+		if (!y)
+			return true;
+		CHECK(div(a, b) == std::bit_cast<TwoInt<u512>>(div(x, y)), x, y);
+		return true;
+	} },
+	{ "div1024", false, 1 << 16, 3, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<TwoInt<TwoInt<uint64_t>>>> u1024;
+		u1024 x = random_value<u1024>(rand), y = random_value<u1024>(rand);
+		y >>= 64 * (16 - i % 16) + rand() % 64;
+		if (!y)
+			return true;
+		TwoInt<u1024> b = div(x, y);
+		CHECK(b.upper < y, x, y, b);
+		CHECK(mul(b.lower, y).lower + b.upper == x, x, y, b);
+		CHECK(b.lower == x / y && b.upper == x % y, x, y, b);
+		return true;
+	} },
+	{ "divmod1024", false, 1 << 16, 2, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<TwoInt<TwoInt<uint64_t>>>> u1024;
+		u1024 x = random_value<u1024>(rand);
+		uint64_t y = rand() >> (i & 63) | 1, r;
+		u1024 q = divmod(x, y, &r);
+		CHECK(r < y && q * y + r == x, x, u1024(y), q);
+		CHECK(q * u1024(y) == x - r && x * y == x * u1024(y), x, u1024(y), q);
+		return true;
+	} },
+#endif
+	{ "mulhi512", false, 1 << 16, 4, [](Case &c, uint64_t, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<TwoInt<TwoInt<uint32_t>>>> u512;
+		u512 x = random_value<u512>(rand), y = random_value<u512>(rand);
+		int s = rand() % 256;
+		CHECK(mulhi(x, y, s) == (mul(x, y) << s).upper, x, y, s);
+		CHECK(sqr(x) == mul(x, x), x);
+		CHECK(sqrhi(x, s) == mulhi(x, x, s), x, s);
+		CHECK(sqr(x.lower.lower) == mul(x.lower.lower, x.lower.lower), x);
+		return true;
+	} },
+#ifdef __SIZEOF_INT128__
+	{ "batch256", false, 1 << 12, 12 * 8, [](Case &c, uint64_t, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<TwoInt<uint64_t>>> u256;
+		const int LANES = 12;
+		u256 x[LANES], y[LANES];
+		TwoIntBatch<u256, LANES> a, b;
+		for (int l = 0; l < LANES; ++l) {
+			x[l] = random_value<u256>(rand);
+			y[l] = l & 1 ? random_value<u256>(rand) : u256(0);
+			a.insert(l, x[l]);
+			b.insert(l, y[l]);
 		}
-	}
-	if (0) {
-		typedef TwoInt<uint16_t> u32;
-		std::random_device rd;
-		std::default_random_engine engine(rd());
-		std::uniform_int_distribution<uint32_t> distribution(0, std::numeric_limits<uint32_t>::max());
-		auto rand = std::bind(distribution, engine);
-		for (int i = 0; i < (1 << 20); ++i) {
-			uint32_t x = rand(), y = rand();
-			uint32_t a = x * y;
-			u32 b = u32(x) * u32(y);
-			assert(a == *reinterpret_cast<uint32_t *>(&b));
+		int s = rand() % 128;
+		TwoIntBatch<u256, LANES> d = a + b, e = a - b, f = a * b, g = mulhi(a, b, s), h = a << s, k = a >> s;
+		auto lt = a < b, eq = a == b;
+		for (int l = 0; l < LANES; ++l) {
+			CHECK(d.extract(l) == x[l] + y[l] && e.extract(l) == x[l] - y[l], x[l], y[l]);
+			CHECK(f.extract(l) == x[l] * y[l] && g.extract(l) == mulhi(x[l], y[l], s), x[l], y[l], s);
+			CHECK(h.extract(l) == (x[l] << s) && k.extract(l) == (x[l] >> s), x[l], s);
+			CHECK(lt[l] == (x[l] < y[l]) && eq[l] == (x[l] == y[l]), x[l], y[l]);
 		}
-	}
-	if (0) {
-		typedef TwoInt<uint16_t> u32;
-		typedef TwoInt<u32> u64;
-		std::random_device rd;
-		std::default_random_engine engine(rd());
-		std::uniform_int_distribution<uint32_t> distribution(0, std::numeric_limits<uint32_t>::max());
-		auto rand = std::bind(distribution, engine);
-		for (int i = 0; i < (1 << 20); ++i) {
-			uint64_t x = rand(), y = rand();
-			uint64_t a = x * y;
-			u64 b = mul(u32(x), u32(y));
-			assert(a == *reinterpret_cast<uint64_t *>(&b));
+		return true;
+	} },
+	{ "sort256", false, 1 << 8, 1000, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<TwoInt<uint64_t>>> u256;
+		const int N = 1000;
+		std::vector<u256> key(N);
+		int a[N], b[N];
+		for (int j = 0; j < N; ++j) {
+			for (int k = 0; k < 4; ++k)
+				key[j] = (key[j] << 64) | u256(rand() % (i & 1 ? 3 : 0 - 1ull));
+			key[j] >>= rand() % 256;
+			a[j] = b[j] = N - 1 - j;
 		}
-	}
-	if (0) {
-		typedef TwoInt<uint32_t> u64;
-		std::random_device rd;
-		std::default_random_engine engine(rd());
-		std::uniform_int_distribution<uint64_t> distribution(0, std::numeric_limits<uint64_t>::max());
-		auto rand = std::bind(distribution, engine);
-		for (int i = 0; i < (1 << 20); ++i) {
-			uint64_t x = rand(), y = rand();
-			uint64_t a = x * y;
-			u64 b = u64(x) * u64(y);
-			assert(a == *reinterpret_cast<uint64_t *>(&b));
+		sort_by_key(a, N, key.data(), i & 2);
+		if (i & 2)
+			std::stable_sort(b, b + N, [&key](int x, int y){ return key[x] > key[y]; });
+		else
+			std::stable_sort(b, b + N, [&key](int x, int y){ return key[x] < key[y]; });
+		int first = std::mismatch(a, a + N, b).first - a;
+		CHECK(first == N, first, a[first], b[first]);
+		return true;
+	} },
+	{ "bits256", false, 1 << 20, 3, [](Case &c, uint64_t, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<uint64_t>> u256;
+		u256 a = random_value<u256>(rand), b = random_value<u256>(rand);
+		a >>= rand() % 257;
+		b >>= rand() % 256;
+		int lz = 0, tz = 0, ones = 0;
+		while (lz < 256 && !a.get(255 - lz))
+			++lz;
+		while (tz < 256 && !a.get(tz))
+			++tz;
+		for (int j = 0; j < 256; ++j)
+			ones += a.get(j);
+		CHECK(clz(a) == lz && ctz(a) == tz && popcount(a) == ones && bit_width(a) == 256 - lz, a);
+		FlatInt<256> x = std::bit_cast<FlatInt<256>>(a), y = std::bit_cast<FlatInt<256>>(b);
+		CHECK(clz(x) == lz && ctz(x) == tz && popcount(x) == ones && bit_width(x) == 256 - lz, x);
+		if (!b)
+			return true;
+		auto q = div(a, b);
+		auto r = div(x, y);
+		CHECK(q.upper < b && q.lower * b + q.upper == a, a, b, q);
+		CHECK(std::bit_cast<u256>(r.lower) == q.lower && std::bit_cast<u256>(r.upper) == q.upper, a, b, q);
+		return true;
+	} },
+	{ "shift256", false, 1 << 16, 256, [](Case &c, uint64_t, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<uint64_t>> u256;
+		u256 a = random_value<u256>(rand);
+		int s = rand() % 300;
+		u256 l = a << s, r = a >> s, x = a, y = a;
+		x <<= s;
+		y >>= s;
+		FlatInt<256> f = std::bit_cast<FlatInt<256>>(a), g = f;
+		f <<= s;
+		g >>= s;
+		for (int j = 0; j < 256; ++j) {
+			bool left = j >= s && a.get(j - s), right = j + s < 256 && a.get(j + s);
+			CHECK(l.get(j) == left && x.get(j) == left && f.get(j) == left, a, s, j);
+			CHECK(r.get(j) == right && y.get(j) == right && g.get(j) == right, a, s, j);
 		}
-	}
-	if (0) {
-		typedef TwoInt<uint32_t> u64;
-		std::random_device rd;
-		std::default_random_engine engine(rd());
-		std::uniform_int_distribution<uint64_t> distribution(1, std::numeric_limits<uint64_t>::max());
-		auto rand = std::bind(distribution, engine);
-		for (int i = 0; i < (1 << 20); ++i) {
-			uint64_t x = rand(), y = rand();
-			uint64_t a = x / y;
-			u64 b = u64(x) / u64(y);
-			assert(a == *reinterpret_cast<uint64_t *>(&b));
+		return true;
+	} },
+	{ "shifted512", false, 1 << 16, 4, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<uint64_t>> u256;
+		typedef TwoInt<u256> u512;
+		u512 a = random_value<u512>(rand), w;
+		u256 b = random_value<u256>(rand);
+		w.lower = b;
+		int k = i & 1 ? 256 : rand() % 600;
+		u512 x = a, y = a;
+		bool carry = add_shifted(x, b, k), borrow = sub_shifted(y, b, k);
+		CHECK(x == a + (w << k) && carry == (x < a), a, b, k);
+		CHECK(y == a - (w << k) && borrow == (a < (w << k)), a, b, k);
+		x = a;
+		x += x;
+		CHECK(x == a << 1, a);
+		x -= x;
+		CHECK(!x, a);
+		return true;
+	} },
+	{ "carry256", false, 1 << 20, 3, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<uint64_t>> u256;
+		typedef TwoInt<u256> u512;
+		u256 a = i & 1 ? random_value<u256>(rand) : u256::max(), b = random_value<u256>(rand);
+		bool carry = rand() & 1, borrow = rand() & 1, d, e;
+		u256 x = add_carry(a, b, carry, &d), y = sub_borrow(a, b, borrow, &e);
+		u512 wa, wb;
+		wa.lower = a;
+		wb.lower = b;
+		u512 sum = wa + wb + u512(carry), diff = wa - wb - u512(borrow);
+		CHECK(x == sum.lower && d == bool(sum.upper), a, b, carry);
+		CHECK(y == diff.lower && e == bool(diff.upper), a, b, borrow);
+		FlatInt<256> f = std::bit_cast<FlatInt<256>>(a), g = std::bit_cast<FlatInt<256>>(b);
+		CHECK(std::bit_cast<u256>(add_carry(f, g, carry, &d)) == x && d == bool(sum.upper), a, b, carry);
+		return true;
+	} },
+	{ "chars", false, 1 << 12, 8, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<TwoInt<TwoInt<uint64_t>>>> u1024;
+		typedef TwoInt<uint64_t> u128;
+		u1024 x = random_value<u1024>(rand) >> (i % 1024), y;
+		char buf[400], ref[400];
+		int n = 0;
+		for (u1024 t = x; n == 0 || t; t = t / uint64_t(10))
+			ref[n++] = '0' + t % uint64_t(10);
+		std::reverse(ref, ref + n);
+		auto r = to_chars(buf, buf + sizeof(buf), x);
+		CHECK(std::string_view(buf, r.ptr) == std::string_view(ref, n), x);
+		CHECK(from_chars(buf, r.ptr, y).ptr == r.ptr && y == x, x, y);
+		r = to_chars(buf, buf + sizeof(buf), x, 16);
+		CHECK(from_chars(buf, r.ptr, y, 16).ptr == r.ptr && y == x, x, y);
+		CHECK(to_chars(buf, buf + n - 1, x).ec == std::errc::value_too_large, x);
+		r = to_chars(buf, buf + sizeof(buf), u1024::max());
+		*r.ptr = '0';
+		CHECK(from_chars(buf, r.ptr + 1, y).ec == std::errc::result_out_of_range, y);
+		CHECK(from_chars(buf, r.ptr, y).ec == std::errc() && y == u1024::max(), y);
+		u128 z = random_value<u128>(rand) >> (i % 128);
+		unsigned __int128 v = std::bit_cast<unsigned __int128>(z);
+		n = 0;
+		do
+			ref[n++] = '0' + v % 10;
+		while (v /= 10);
+		std::reverse(ref, ref + n);
+		r = to_chars(buf, buf + sizeof(buf), z);
+		CHECK(std::string_view(buf, r.ptr) == std::string_view(ref, n), z);
+		v = std::bit_cast<unsigned __int128>(z);
+		n = 0;
+		do
+			ref[n++] = "0123456789abcdef"[v % 16];
+		while (v /= 16);
+		std::reverse(ref, ref + n);
+		r = to_chars(buf, buf + sizeof(buf), z, 16);
+		CHECK(std::string_view(buf, r.ptr) == std::string_view(ref, n), z);
+		return true;
+	} },
+	{ "montgomery", false, 1 << 12, 5, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<uint64_t>> u256;
+		typedef TwoInt<u256> u512;
+		u256 m = random_value<u256>(rand) >> (i % 192) | u256(1), a = random_value<u256>(rand) % m, b = random_value<u256>(rand) % m;
+		u512 wm;
+		wm.lower = m;
+		auto mulmod = [&wm](const u256 &x, const u256 &y) { return (mul(x, y) % wm).lower; };
+		MontgomeryContext<u256> ctx(m);
+		MontgomeryContext<u256, true> safe(m);
+		MontgomeryContext<FlatInt<512>> flat(std::bit_cast<FlatInt<512>>(wm));
+		u256 x = ctx.to_montgomery(a), y = ctx.to_montgomery(b);
+		CHECK(ctx.from_montgomery(ctx.multiply(x, y)) == mulmod(a, b), m, a, b);
+		CHECK(ctx.from_montgomery(ctx.square(x)) == mulmod(a, a), m, a);
+		u256 e = random_value<u256>(rand) >> (i % 256), r(1);
+		for (int k = bit_width(e) - 1; k >= 0; --k) {
+			r = mulmod(r, r);
+			if (e.get(k))
+				r = mulmod(r, a);
 		}
-	}
-	if (0) {
+		r = r % m;
+		CHECK(ctx.power(a, e) == r, m, a, e, r);
+		CHECK(safe.power(a, e) == r, m, a, e, r);
+		u512 wa, we;
+		wa.lower = a;
+		we.lower = e;
+		CHECK(std::bit_cast<u512>(flat.power(std::bit_cast<FlatInt<512>>(wa), std::bit_cast<FlatInt<512>>(we))).lower == r, m, a, e, r);
+		return true;
+	} },
+	{ "divider", false, 1 << 12, 64 * 4, [](Case &c, uint64_t i, Xoshiro &rand) {
+		typedef TwoInt<TwoInt<uint64_t>> u256;
 		typedef TwoInt<uint32_t> u64;
-		std::random_device rd;
-		std::default_random_engine engine(rd());
-		std::uniform_int_distribution<uint64_t> distribution(1, std::numeric_limits<uint64_t>::max());
-		auto rand = std::bind(distribution, engine);
-		for (int i = 0; i < (1 << 20); ++i) {
-			uint64_t x = rand(), y = rand();
-			uint64_t a = x % y;
-			u64 b = u64(x) % u64(y);
-			assert(a == *reinterpret_cast<uint64_t *>(&b));
+		u256 d = random_value<u256>(rand) >> (i % 256);
+		if (i % 7 == 0)
+			d = u256(1) << (i % 256);
+		if (i % 7 == 1 || !d)
+			d = u256::max() >> (i % 256);
+		Divider<u256> divider(d);
+		Divider<FlatInt<256>> flat(std::bit_cast<FlatInt<256>>(d));
+		uint64_t e = nonzero(rand() >> (i % 64));
+		Divider<u64> small(e);
+		for (int j = 0; j < 64; ++j) {
+			u256 x = j ? random_value<u256>(rand) >> (rand() % 256) : u256::max(), q = x / d, r = x % d;
+			CHECK(x / divider == q && x % divider == r, x, d);
+			FlatInt<256> y = std::bit_cast<FlatInt<256>>(x);
+			CHECK(std::bit_cast<u256>(y / flat) == q && std::bit_cast<u256>(y % flat) == r, x, d);
+			uint64_t z = j ? rand() : ~uint64_t(0);
+			CHECK(std::bit_cast<uint64_t>(u64(z) / small) == z / e && std::bit_cast<uint64_t>(u64(z) % small) == z % e, u64(z), u64(e));
 		}
-	}
-	if (0) {
-		typedef TwoInt<uint32_t> u64;
-		std::random_device rd;
-		std::default_random_engine engine(rd());
-		std::uniform_int_distribution<uint64_t> distribution(1, std::numeric_limits<uint64_t>::max());
-		auto rand = std::bind(distribution, engine);
-		for (int i = 0; i < (1 << 20); ++i) {
-			uint64_t x = rand(), y = rand();
-			uint64_t quotient = x / y;
-			uint64_t remainder = x % y;
-			TwoInt<u64> b = div(u64(x), u64(y));
-			assert(quotient == *reinterpret_cast<uint64_t *>(&(b.lower)));
-			assert(remainder == *reinterpret_cast<uint64_t *>(&(b.upper)));
+		return true;
+	} },
+#endif
+	{ "polar_const1", false, 15 * 3 * 7, 1, [](Case &c, uint64_t i, Xoshiro &) {
+		int numerator = polar_rates[i % 7][0], denominator = polar_rates[i % 7][1];
+		return polar_case(i / 7 % 3, i / 21, [&](auto type, auto order) {
+			typedef typename decltype(type)::type TYPE;
+			const int ORDER = order, LENGTH = 1 << ORDER;
+			auto a = polar_run<PolarCodeConst0<TYPE, ORDER>>(numerator, denominator, 1);
+			auto b = polar_run<PolarCodeConst1<TYPE, ORDER>>(numerator, denominator, 1);
+			int first = polar_mismatch(a, b);
+			CHECK(first == LENGTH, ORDER, sizeof(TYPE) * 8, numerator, denominator, first);
+			return true;
+		});
+	} },
+	{ "polar_threads", false, 15 * 3 * 8, 3, [](Case &c, uint64_t i, Xoshiro &rand) {
+		int threads = 1 + i % 8, rate = rand() % 7;
+		int numerator = polar_rates[rate][0], denominator = polar_rates[rate][1];
+		return polar_case(i / 8 % 3, i / 24, [&](auto type, auto order) {
+			typedef typename decltype(type)::type TYPE;
+			const int ORDER = order, LENGTH = 1 << ORDER;
+			int size = subtree_size(LENGTH, threads), tasks = std::min(LENGTH, 4 * threads);
+			CHECK(std::has_single_bit(unsigned(size)) && LENGTH / size >= tasks && LENGTH / size < 2 * tasks, ORDER, threads, size);
+			auto a = polar_run<PolarCodeConst0<TYPE, ORDER>>(numerator, denominator, 1);
+			auto b = polar_run<PolarCodeConst0<TYPE, ORDER>>(numerator, denominator, threads);
+			auto d = polar_run<PolarCodeConst1<TYPE, ORDER>>(numerator, denominator, threads);
+			int first = polar_mismatch(a, b), second = polar_mismatch(a, d);
+			CHECK(first == LENGTH, ORDER, sizeof(TYPE) * 8, numerator, denominator, threads, first);
+			CHECK(second == LENGTH, ORDER, sizeof(TYPE) * 8, numerator, denominator, threads, second);
+			return true;
+		});
+	} },
+	{ "polar_hybrid", false, 15 * 3 * 7, 1, [](Case &c, uint64_t i, Xoshiro &rand) {
+		int threads = 1 + rand() % 4;
+		int numerator = polar_rates[i % 7][0], denominator = polar_rates[i % 7][1];
+		return polar_case(i / 7 % 3, i / 21, [&](auto type, auto order) {
+			typedef typename decltype(type)::type TYPE;
+			const int ORDER = order, LENGTH = 1 << ORDER;
+			auto a = polar_run<PolarCodeConst0<TYPE, ORDER>>(numerator, denominator, 1);
+			auto b = polar_run<PolarCodeHybrid<TYPE, ORDER>>(numerator, denominator, threads);
+			int first = polar_mismatch(a, b);
+			CHECK(first == LENGTH, ORDER, sizeof(TYPE) * 8, numerator, denominator, threads, first);
+			return true;
+		});
+	} },
+	{ "polar_runtime", false, 15 * 3 * 7, 1, [](Case &c, uint64_t i, Xoshiro &rand) {
+		int threads = 1 + rand() % 8;
+		int numerator = polar_rates[i % 7][0], denominator = polar_rates[i % 7][1];
+		return polar_case(i / 7 % 3, i / 21, [&](auto type, auto order) {
+			typedef typename decltype(type)::type TYPE;
+			const int ORDER = order, LENGTH = 1 << ORDER;
+			int block_order = rand() % (ORDER + 2);
+			auto a = polar_run<PolarCodeConst0<TYPE, ORDER>>(numerator, denominator, 1);
+			PolarCodeRuntime<TYPE> engine(ORDER, block_order);
+			std::vector<int> b(LENGTH);
+			engine(b.data(), numerator, denominator, threads);
+			int first = polar_mismatch(a, b);
+			CHECK(first == LENGTH, ORDER, sizeof(TYPE) * 8, numerator, denominator, block_order, threads, first);
+			return true;
+		});
+	} },
+	{ "polar_cache", false, 1 << 8, 27, [](Case &c, uint64_t i, Xoshiro &rand) {
+		const char *dir = std::getenv("TMPDIR");
+		std::string path = std::string(dir ? dir : "/tmp") + "/testbench_polar_cache_" + std::to_string(getpid()) + "_" + std::to_string(i);
+		struct Remove { const std::string &path; ~Remove() { std::remove(path.c_str()); } } remove { path };
+		std::vector<PolarSequence> points;
+		for (int n = 1 + rand() % 8; int(points.size()) < n;) {
+			int order = rand() % 11, denominator = 1 + rand() % 100, numerator = rand() % (denominator + 1);
+			PolarSequence point { order, numerator, denominator, 64 << rand() % 7, std::vector<int32_t>(1 << order) };
+			for (auto &index: point.sequence)
+				index = rand();
+			if (std::none_of(points.begin(), points.end(), [&point](const PolarSequence &seq) { return !(seq < point) && !(point < seq); }))
+				points.push_back(point);
+		}
+		CHECK(polar_cache_write(path.c_str(), points), path);
+		PolarCache cache;
+		CHECK(cache.open(path.c_str()) && cache.count() == int(points.size()), path, points.size());
+		for (auto &point: points) {
+			auto entry = cache.find(point.order, point.numerator, point.denominator);
+			CHECK(entry && int(entry->bits) == point.bits, point.order, point.numerator, point.denominator);
+			CHECK(std::equal(point.sequence.begin(), point.sequence.end(), cache.sequence(*entry)), point.order, point.numerator, point.denominator);
+			CHECK(!cache.find(point.order, point.numerator, point.denominator + 100), point.order, point.numerator, point.denominator);
+		}
+		CHECK(!cache.find(11, 1, 2) && !cache.find(0, 0, 0), path);
+		cache.close();
+		std::vector<char> bytes;
+		if (FILE *file = std::fopen(path.c_str(), "rb")) {
+			for (int byte; (byte = std::fgetc(file)) != EOF;)
+				bytes.push_back(byte);
+			std::fclose(file);
 		}
+		auto rejected = [&path, &cache](const std::vector<char> &corrupt) {
+			FILE *file = std::fopen(path.c_str(), "wb");
+			if (!file)
+				return false;
+			std::fwrite(corrupt.data(), 1, corrupt.size(), file);
+			std::fclose(file);
+			return !cache.open(path.c_str()) && !cache.count();
+		};
+		auto corrupt = [&bytes](size_t offset, auto value) {
+			std::vector<char> tmp = bytes;
+			std::memcpy(tmp.data() + offset, &value, sizeof(value));
+			return tmp;
+		};
+		size_t entry = sizeof(PolarCacheHeader) + rand() % points.size() * sizeof(PolarCacheEntry);
+		size_t table = sizeof(PolarCacheHeader) + points.size() * sizeof(PolarCacheEntry);
+		CHECK(rejected(corrupt(offsetof(PolarCacheHeader, version), polar_cache_version + 1)), path);
+		CHECK(rejected(corrupt(offsetof(PolarCacheHeader, magic), 'X')), path);
+		CHECK(rejected(corrupt(offsetof(PolarCacheHeader, count), ~uint32_t(0))), path);
+		CHECK(rejected(std::vector<char>(bytes.begin(), bytes.end() - sizeof(int32_t))), path);
+		CHECK(rejected(std::vector<char>(bytes.begin(), bytes.begin() + sizeof(PolarCacheHeader) - 1)), path);
+		CHECK(rejected(corrupt(entry + offsetof(PolarCacheEntry, offset), uint64_t(bytes.size()))), path);
+		CHECK(rejected(corrupt(entry + offsetof(PolarCacheEntry, offset), uint64_t(sizeof(PolarCacheHeader) + 2))), path);
+		CHECK(rejected(corrupt(entry + offsetof(PolarCacheEntry, offset), uint64_t(table - sizeof(int32_t)))), path);
+		CHECK(rejected(corrupt(entry + offsetof(PolarCacheEntry, offset), ~uint64_t(0) & ~uint64_t(3))), path);
+		CHECK(rejected(corrupt(entry + offsetof(PolarCacheEntry, order), uint32_t(31))), path);
+		std::vector<char> unsorted = bytes;
+		std::memcpy(unsorted.data() + table - sizeof(PolarCacheEntry), bytes.data() + sizeof(PolarCacheHeader), sizeof(PolarCacheEntry));
+		CHECK(points.size() < 2 || rejected(unsorted), path);
+		return true;
+	} },
+	{ "polar_incremental", false, 15 * 3 * 7, 2, [](Case &c, uint64_t i, Xoshiro &rand) {
+		int threads = 1 + rand() % 8;
+		int numerator = polar_rates[i % 7][0], denominator = polar_rates[i % 7][1];
+		return polar_case(i / 7 % 3, i / 21, [&](auto type, auto order) {
+			typedef typename decltype(type)::type TYPE;
+			const int ORDER = order, LENGTH = 1 << ORDER;
+			PolarCodeIncremental<TYPE> tree(numerator, denominator);
+			std::vector<int> b(LENGTH);
+			if constexpr (ORDER > 0) {
+				tree.extend(ORDER - 1, threads);
+				auto a = polar_run<PolarCodeConst0<TYPE, ORDER - 1>>(numerator, denominator, 1);
+				tree(b.data());
+				int first = std::mismatch(a.begin(), a.end(), b.begin()).first - a.begin();
+				CHECK(first == LENGTH / 2, ORDER - 1, sizeof(TYPE) * 8, numerator, denominator, threads, first);
+				tree.extend(1, threads);
+			}
+			auto a = polar_run<PolarCodeConst0<TYPE, ORDER>>(numerator, denominator, 1);
+			tree(b.data());
+			int first = polar_mismatch(a, b);
+			CHECK(tree.order == ORDER && first == LENGTH, ORDER, sizeof(TYPE) * 8, numerator, denominator, threads, first);
+			return true;
+		});
+	} },
+};
+
+bool run_suite(const Suite &suite, int threads, uint64_t seed)
+{
+	const uint64_t CHUNK = suite.exhaustive ? 1 : std::clamp<uint64_t>(suite.items / (64 * threads), 1, 256);
+	std::atomic<uint64_t> next(0), done(0), failed(suite.items);
+	std::mutex mutex;
+	std::string message;
+	auto work = [&]() {
+		Xoshiro rand;
+		Case c;
+		while (true) {
+			uint64_t begin = next.fetch_add(CHUNK);
+			if (begin >= suite.items || begin >= failed)
+				break;
+			uint64_t end = std::min(begin + CHUNK, suite.items);
+			for (uint64_t item = begin; item < end; ++item) {
+				rand.seed(seed, item);
+				if (!suite.check(c, item, rand)) {
+					std::lock_guard<std::mutex> lock(mutex);
+					if (item < failed) {
+						failed = item;
+						message = c.message;
+					}
+					break;
+				}
+				++done;
+			}
+		}
+	};
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> pool;
+	for (int t = 1; t < threads; ++t)
+		pool.emplace_back(work);
+	work();
+	for (auto &thread: pool)
+		thread.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double checks = double(done) * suite.checks;
+	std::cout << std::dec << std::setprecision(3) << suite.name << ": " << (failed < suite.items ? "FAIL" : "pass") << " "
+		<< checks << " checks in " << seconds << " s (" << checks / seconds / 1e6 << " M/s)" << std::endl;
+	if (failed < suite.items)
+		std::cout << "  first failing item " << std::dec << failed << " with seed " << seed << "\n  " << message << std::endl;
+	return failed == suite.items;
+}
+
+int main(int argc, char **argv)
+{
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	uint64_t seed = std::random_device()();
+	std::vector<const Suite *> selected;
+	for (int i = 1; i < argc; ++i) {
+		bool found = false;
+		if (!std::strcmp(argv[i], "-j") && i + 1 < argc) {
+			threads = std::max(1, std::atoi(argv[++i]));
+			continue;
+		}
+		if (!std::strcmp(argv[i], "-s") && i + 1 < argc) {
+			seed = std::strtoull(argv[++i], nullptr, 0);
+			continue;
+		}
+		for (auto &suite: suites) {
+			bool all = !std::strcmp(argv[i], "all");
+			bool random = !std::strcmp(argv[i], "random") && !suite.exhaustive;
+			bool exhaustive = !std::strcmp(argv[i], "exhaustive") && suite.exhaustive;
+			if (all || random || exhaustive || !std::strcmp(argv[i], suite.name)) {
+				selected.push_back(&suite);
+				found = true;
+			}
+		}
+		if (!found) {
+			std::cerr << "usage: " << argv[0] << " [-j THREADS] [-s SEED] [all|random|exhaustive|SUITE]..." << std::endl << "suites:";
+			for (auto &suite: suites)
+				std::cerr << " " << suite.name;
+			std::cerr << std::endl;
+			return 1;
+		}
+	}
+	if (!selected.empty()) {
+		std::cout << "threads: " << threads << " seed: " << seed << std::endl;
+		int failures = 0;
+		for (auto suite: selected)
+			failures += !run_suite(*suite, threads, seed);
+		return failures != 0;
 	}
 	//TwoInt<TwoInt<TwoInt<TwoInt<uint8_t>>>> a(15), b(3);
 	//TwoInt<TwoInt<uint8_t>> a(15), b(3);
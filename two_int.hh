@@ -6,26 +6,165 @@ Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
 
 #pragma once
 
+#include <bit>
+#include <array>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+
+#ifndef KARATSUBA_THRESHOLD
+#define KARATSUBA_THRESHOLD 512
+#endif
+
+constexpr uint64_t funnel_left(uint64_t upper, uint64_t lower, int shift)
+{
+#ifdef __SIZEOF_INT128__
+	return ((unsigned __int128)upper << 64 | lower) << shift >> 64;
+#else
+	return upper << shift | lower >> 1 >> (63 - shift);
+#endif
+}
+
+constexpr uint64_t funnel_right(uint64_t upper, uint64_t lower, int shift)
+{
+#ifdef __SIZEOF_INT128__
+	return ((unsigned __int128)upper << 64 | lower) >> shift;
+#else
+	return lower >> shift | upper << 1 << (63 - shift);
+#endif
+}
+
+constexpr void shift_limbs_left(uint64_t *limb, int length, int i)
+{
+	int l = i < 64 * length ? i / 64 : length, b = i % 64;
+	for (int j = length - 1; j > l; --j)
+		limb[j] = funnel_left(limb[j - l], limb[j - l - 1], b);
+	if (l < length)
+		limb[l] = limb[0] << b;
+	for (int j = 0; j < l; ++j)
+		limb[j] = 0;
+}
+
+constexpr void shift_limbs_right(uint64_t *limb, int length, int i)
+{
+	int l = i < 64 * length ? i / 64 : length, b = i % 64;
+	for (int j = 0; j < length - l - 1; ++j)
+		limb[j] = funnel_right(limb[j + l + 1], limb[j + l], b);
+	if (l < length)
+		limb[length - l - 1] = limb[length - 1] >> b;
+	for (int j = length - l; j < length; ++j)
+		limb[j] = 0;
+}
+
+template <typename TYPE>
+constexpr bool add_to(TYPE &a, const TYPE &b, bool carry)
+{
+	TYPE sum;
+	bool overflow = __builtin_add_overflow(a, b, &sum);
+	overflow |= __builtin_add_overflow(sum, TYPE(carry), &a);
+	return overflow;
+}
+
+template <typename TYPE>
+constexpr bool sub_from(TYPE &a, const TYPE &b, bool borrow)
+{
+	TYPE diff;
+	bool overflow = __builtin_sub_overflow(a, b, &diff);
+	overflow |= __builtin_sub_overflow(diff, TYPE(borrow), &a);
+	return overflow;
+}
+
+#ifdef __x86_64__
+constexpr bool add_to(uint64_t &a, const uint64_t &b, bool carry)
+{
+	if (std::is_constant_evaluated())
+		return add_to<uint64_t>(a, b, carry);
+	unsigned long long sum;
+	carry = _addcarry_u64(carry, a, b, &sum);
+	a = sum;
+	return carry;
+}
+
+constexpr bool sub_from(uint64_t &a, const uint64_t &b, bool borrow)
+{
+	if (std::is_constant_evaluated())
+		return sub_from<uint64_t>(a, b, borrow);
+	unsigned long long diff;
+	borrow = _subborrow_u64(borrow, a, b, &diff);
+	a = diff;
+	return borrow;
+}
+#endif
+
+template <typename TYPE>
+constexpr TYPE add_carry(const TYPE &a, const TYPE &b, bool carry, bool *carry_out)
+{
+	TYPE sum = a;
+	carry = add_to(sum, b, carry);
+	if (carry_out)
+		*carry_out = carry;
+	return sum;
+}
+
+template <typename TYPE>
+constexpr TYPE sub_borrow(const TYPE &a, const TYPE &b, bool borrow, bool *borrow_out)
+{
+	TYPE diff = a;
+	borrow = sub_from(diff, b, borrow);
+	if (borrow_out)
+		*borrow_out = borrow;
+	return diff;
+}
+
+constexpr bool add_limbs_shifted(uint64_t *a, int m, const uint64_t *b, int n, int k)
+{
+	int l = k / 64, s = k % 64;
+	bool carry = false;
+	for (int j = l, i = 0; j < m; ++j, ++i) {
+		if (i > n && !carry)
+			break;
+		uint64_t upper = i < n ? b[i] : 0, lower = i > 0 && i <= n ? b[i - 1] : 0;
+		carry = add_to(a[j], funnel_left(upper, lower, s), carry);
+	}
+	return carry;
+}
+
+constexpr bool sub_limbs_shifted(uint64_t *a, int m, const uint64_t *b, int n, int k)
+{
+	int l = k / 64, s = k % 64;
+	bool borrow = false;
+	for (int j = l, i = 0; j < m; ++j, ++i) {
+		if (i > n && !borrow)
+			break;
+		uint64_t upper = i < n ? b[i] : 0, lower = i > 0 && i <= n ? b[i - 1] : 0;
+		borrow = sub_from(a[j], funnel_left(upper, lower, s), borrow);
+	}
+	return borrow;
+}
+
 template <typename TYPE>
 struct TwoInt
 {
 	TYPE lower, upper;
-	TwoInt() : lower(0), upper(0) {}
-	TwoInt(uint64_t value) : lower(value), upper(8 <= sizeof(TYPE) ? 0 : value >> (sizeof(TYPE) * 8)) {}
-	static TwoInt<TYPE> one()
+	constexpr TwoInt() : lower(0), upper(0) {}
+	constexpr TwoInt(uint64_t value) : lower(value), upper(8 <= sizeof(TYPE) ? 0 : value >> (sizeof(TYPE) * 8)) {}
+	static constexpr TwoInt<TYPE> one()
 	{
 		TwoInt<TYPE> tmp;
 		tmp.lower = TYPE::one();
 		return tmp;
 	}
-	static TwoInt<TYPE> max()
+	static constexpr TwoInt<TYPE> max()
 	{
 		TwoInt<TYPE> tmp;
 		tmp.lower = TYPE::max();
 		tmp.upper = TYPE::max();
 		return tmp;
 	}
-	void set(int index)
+	constexpr void set(int index)
 	{
 		int h = sizeof(TYPE) * 8;
 		if (index < h)
@@ -33,7 +172,7 @@ struct TwoInt
 		else if (index < 2 * h)
 			upper.set(index - h);
 	}
-	void reset(int index)
+	constexpr void reset(int index)
 	{
 		int h = sizeof(TYPE) * 8;
 		if (index < h)
@@ -41,7 +180,7 @@ struct TwoInt
 		else if (index < 2 * h)
 			upper.reset(index - h);
 	}
-	bool get(int index)
+	constexpr bool get(int index)
 	{
 		int h = sizeof(TYPE) * 8;
 		if (index < h)
@@ -50,69 +189,109 @@ struct TwoInt
 			return upper.get(index - h);
 		return false;
 	}
-	explicit operator bool () const
+	explicit constexpr operator bool () const
 	{
 		return lower || upper;
 	}
-	TwoInt<TYPE> operator|=(TwoInt<TYPE> a)
+	constexpr TwoInt<TYPE> &operator|=(const TwoInt<TYPE> &a)
+	{
+		lower |= a.lower;
+		upper |= a.upper;
+		return *this;
+	}
+	constexpr TwoInt<TYPE> &operator&=(const TwoInt<TYPE> &a)
+	{
+		lower &= a.lower;
+		upper &= a.upper;
+		return *this;
+	}
+	constexpr TwoInt<TYPE> &operator^=(const TwoInt<TYPE> &a)
+	{
+		lower ^= a.lower;
+		upper ^= a.upper;
+		return *this;
+	}
+	constexpr TwoInt<TYPE> &operator>>=(int i)
+	{
+		if constexpr (sizeof(TYPE) % sizeof(uint64_t)) {
+			return *this = *this >> i;
+		} else {
+			auto limb = std::bit_cast<std::array<uint64_t, sizeof(TwoInt<TYPE>) / sizeof(uint64_t)>>(*this);
+			shift_limbs_right(limb.data(), limb.size(), i);
+			return *this = std::bit_cast<TwoInt<TYPE>>(limb);
+		}
+	}
+	constexpr TwoInt<TYPE> &operator<<=(int i)
 	{
-		return *this = *this | a;
+		if constexpr (sizeof(TYPE) % sizeof(uint64_t)) {
+			return *this = *this << i;
+		} else {
+			auto limb = std::bit_cast<std::array<uint64_t, sizeof(TwoInt<TYPE>) / sizeof(uint64_t)>>(*this);
+			shift_limbs_left(limb.data(), limb.size(), i);
+			return *this = std::bit_cast<TwoInt<TYPE>>(limb);
+		}
 	}
-	TwoInt<TYPE> operator&=(TwoInt<TYPE> a)
+	constexpr TwoInt<TYPE> &operator+=(const TwoInt<TYPE> &a)
 	{
-		return *this = *this & a;
+		add_to(*this, a, false);
+		return *this;
 	}
-	TwoInt<TYPE> operator^=(TwoInt<TYPE> a)
+	constexpr TwoInt<TYPE> &operator-=(const TwoInt<TYPE> &a)
 	{
-		return *this = *this ^ a;
+		sub_from(*this, a, false);
+		return *this;
 	}
-	TwoInt<TYPE> operator>>=(int i)
+	constexpr TwoInt<TYPE> &operator*=(const TwoInt<TYPE> &a)
 	{
-		return *this = *this >> i;
+		return *this = *this * a;
 	}
-	TwoInt<TYPE> operator<<=(int i)
+	constexpr TwoInt<TYPE> &operator/=(const TwoInt<TYPE> &a)
 	{
-		return *this = *this << i;
+		return *this = *this / a;
 	}
-	TwoInt<TYPE> operator+=(TwoInt<TYPE> a)
+	constexpr TwoInt<TYPE> &operator%=(const TwoInt<TYPE> &a)
+	{
+		return *this = *this % a;
+	}
+	constexpr TwoInt<TYPE> &operator+=(uint64_t a)
 	{
 		return *this = *this + a;
 	}
-	TwoInt<TYPE> operator-=(TwoInt<TYPE> a)
+	constexpr TwoInt<TYPE> &operator-=(uint64_t a)
 	{
 		return *this = *this - a;
 	}
-	TwoInt<TYPE> operator*=(TwoInt<TYPE> a)
+	constexpr TwoInt<TYPE> &operator*=(uint64_t a)
 	{
 		return *this = *this * a;
 	}
-	TwoInt<TYPE> operator/=(TwoInt<TYPE> a)
+	constexpr TwoInt<TYPE> &operator/=(uint64_t a)
 	{
 		return *this = *this / a;
 	}
-	TwoInt<TYPE> operator%=(TwoInt<TYPE> a)
+	constexpr TwoInt<TYPE> &operator%=(uint64_t a)
 	{
-		return *this = *this % a;
+		return *this = TwoInt<TYPE>(*this % a);
 	}
-	TwoInt<TYPE> operator++()
+	constexpr TwoInt<TYPE> &operator++()
 	{
 		if (!++lower)
 			++upper;
 		return *this;
 	}
-	TwoInt<TYPE> operator--()
+	constexpr TwoInt<TYPE> &operator--()
 	{
 		if (!lower--)
 			--upper;
 		return *this;
 	}
-	TwoInt<TYPE> operator++(int)
+	constexpr TwoInt<TYPE> operator++(int)
 	{
 		TwoInt<TYPE> tmp = *this;
 		++(*this);
 		return tmp;
 	}
-	TwoInt<TYPE> operator--(int)
+	constexpr TwoInt<TYPE> operator--(int)
 	{
 		TwoInt<TYPE> tmp = *this;
 		--(*this);
@@ -121,7 +300,7 @@ struct TwoInt
 };
 
 template <>
-TwoInt<uint8_t> TwoInt<uint8_t>::one()
+constexpr TwoInt<uint8_t> TwoInt<uint8_t>::one()
 {
 	TwoInt<uint8_t> tmp;
 	tmp.lower = 1;
@@ -129,7 +308,7 @@ TwoInt<uint8_t> TwoInt<uint8_t>::one()
 }
 
 template <>
-TwoInt<uint16_t> TwoInt<uint16_t>::one()
+constexpr TwoInt<uint16_t> TwoInt<uint16_t>::one()
 {
 	TwoInt<uint16_t> tmp;
 	tmp.lower = 1;
@@ -137,7 +316,7 @@ TwoInt<uint16_t> TwoInt<uint16_t>::one()
 }
 
 template <>
-TwoInt<uint32_t> TwoInt<uint32_t>::one()
+constexpr TwoInt<uint32_t> TwoInt<uint32_t>::one()
 {
 	TwoInt<uint32_t> tmp;
 	tmp.lower = 1;
@@ -145,7 +324,15 @@ TwoInt<uint32_t> TwoInt<uint32_t>::one()
 }
 
 template <>
-TwoInt<uint8_t> TwoInt<uint8_t>::max()
+constexpr TwoInt<uint64_t> TwoInt<uint64_t>::one()
+{
+	TwoInt<uint64_t> tmp;
+	tmp.lower = 1;
+	return tmp;
+}
+
+template <>
+constexpr TwoInt<uint8_t> TwoInt<uint8_t>::max()
 {
 	TwoInt<uint8_t> tmp;
 	tmp.lower = 255;
@@ -154,7 +341,7 @@ TwoInt<uint8_t> TwoInt<uint8_t>::max()
 }
 
 template <>
-TwoInt<uint16_t> TwoInt<uint16_t>::max()
+constexpr TwoInt<uint16_t> TwoInt<uint16_t>::max()
 {
 	TwoInt<uint16_t> tmp;
 	tmp.lower = 65535;
@@ -163,7 +350,7 @@ TwoInt<uint16_t> TwoInt<uint16_t>::max()
 }
 
 template <>
-TwoInt<uint32_t> TwoInt<uint32_t>::max()
+constexpr TwoInt<uint32_t> TwoInt<uint32_t>::max()
 {
 	TwoInt<uint32_t> tmp;
 	tmp.lower = 4294967295;
@@ -172,7 +359,16 @@ TwoInt<uint32_t> TwoInt<uint32_t>::max()
 }
 
 template <>
-void TwoInt<uint8_t>::set(int index)
+constexpr TwoInt<uint64_t> TwoInt<uint64_t>::max()
+{
+	TwoInt<uint64_t> tmp;
+	tmp.lower = 18446744073709551615ULL;
+	tmp.upper = 18446744073709551615ULL;
+	return tmp;
+}
+
+template <>
+constexpr void TwoInt<uint8_t>::set(int index)
 {
 	if (index < 8)
 		lower |= 1 << index;
@@ -181,7 +377,7 @@ void TwoInt<uint8_t>::set(int index)
 }
 
 template <>
-void TwoInt<uint16_t>::set(int index)
+constexpr void TwoInt<uint16_t>::set(int index)
 {
 	if (index < 16)
 		lower |= 1 << index;
@@ -190,7 +386,7 @@ void TwoInt<uint16_t>::set(int index)
 }
 
 template <>
-void TwoInt<uint32_t>::set(int index)
+constexpr void TwoInt<uint32_t>::set(int index)
 {
 	if (index < 32)
 		lower |= 1 << index;
@@ -199,7 +395,16 @@ void TwoInt<uint32_t>::set(int index)
 }
 
 template <>
-void TwoInt<uint8_t>::reset(int index)
+constexpr void TwoInt<uint64_t>::set(int index)
+{
+	if (index < 64)
+		lower |= uint64_t(1) << index;
+	else if (index < 128)
+		upper |= uint64_t(1) << (index - 64);
+}
+
+template <>
+constexpr void TwoInt<uint8_t>::reset(int index)
 {
 	if (index < 8)
 		lower &= ~(1 << index);
@@ -208,7 +413,7 @@ void TwoInt<uint8_t>::reset(int index)
 }
 
 template <>
-void TwoInt<uint16_t>::reset(int index)
+constexpr void TwoInt<uint16_t>::reset(int index)
 {
 	if (index < 16)
 		lower &= ~(1 << index);
@@ -217,7 +422,7 @@ void TwoInt<uint16_t>::reset(int index)
 }
 
 template <>
-void TwoInt<uint32_t>::reset(int index)
+constexpr void TwoInt<uint32_t>::reset(int index)
 {
 	if (index < 32)
 		lower &= ~(1 << index);
@@ -226,7 +431,16 @@ void TwoInt<uint32_t>::reset(int index)
 }
 
 template <>
-bool TwoInt<uint8_t>::get(int index)
+constexpr void TwoInt<uint64_t>::reset(int index)
+{
+	if (index < 64)
+		lower &= ~(uint64_t(1) << index);
+	else if (index < 128)
+		upper &= ~(uint64_t(1) << (index - 64));
+}
+
+template <>
+constexpr bool TwoInt<uint8_t>::get(int index)
 {
 	if (index < 8)
 		return lower & (1 << index);
@@ -236,7 +450,7 @@ bool TwoInt<uint8_t>::get(int index)
 }
 
 template <>
-bool TwoInt<uint16_t>::get(int index)
+constexpr bool TwoInt<uint16_t>::get(int index)
 {
 	if (index < 16)
 		return lower & (1 << index);
@@ -246,7 +460,7 @@ bool TwoInt<uint16_t>::get(int index)
 }
 
 template <>
-bool TwoInt<uint32_t>::get(int index)
+constexpr bool TwoInt<uint32_t>::get(int index)
 {
 	if (index < 32)
 		return lower & (1 << index);
@@ -255,44 +469,104 @@ bool TwoInt<uint32_t>::get(int index)
 	return false;
 }
 
+template <>
+constexpr bool TwoInt<uint64_t>::get(int index)
+{
+	if (index < 64)
+		return lower & (uint64_t(1) << index);
+	if (index < 128)
+		return upper & (uint64_t(1) << (index - 64));
+	return false;
+}
+
+constexpr uint16_t pack(TwoInt<uint8_t> a)
+{
+	return uint16_t(a.upper) << 8 | a.lower;
+}
+
+constexpr uint32_t pack(TwoInt<uint16_t> a)
+{
+	return uint32_t(a.upper) << 16 | a.lower;
+}
+
+constexpr uint64_t pack(TwoInt<uint32_t> a)
+{
+	return uint64_t(a.upper) << 32 | a.lower;
+}
+
 template <typename TYPE>
-bool operator==(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr int clz(const TwoInt<TYPE> &a)
+{
+	int h = sizeof(TYPE) * 8;
+	if constexpr (std::is_integral<TYPE>::value)
+		return a.upper ? std::countl_zero(a.upper) : h + std::countl_zero(a.lower);
+	else
+		return a.upper ? clz(a.upper) : h + clz(a.lower);
+}
+
+template <typename TYPE>
+constexpr int ctz(const TwoInt<TYPE> &a)
+{
+	int h = sizeof(TYPE) * 8;
+	if constexpr (std::is_integral<TYPE>::value)
+		return a.lower ? std::countr_zero(a.lower) : h + std::countr_zero(a.upper);
+	else
+		return a.lower ? ctz(a.lower) : h + ctz(a.upper);
+}
+
+template <typename TYPE>
+constexpr int popcount(const TwoInt<TYPE> &a)
+{
+	if constexpr (std::is_integral<TYPE>::value)
+		return std::popcount(a.lower) + std::popcount(a.upper);
+	else
+		return popcount(a.lower) + popcount(a.upper);
+}
+
+template <typename TYPE>
+constexpr int bit_width(const TwoInt<TYPE> &a)
+{
+	return sizeof(a) * 8 - clz(a);
+}
+
+template <typename TYPE>
+constexpr bool operator==(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
 	return a.upper == b.upper && a.lower == b.lower;
 }
 
 template <typename TYPE>
-bool operator!=(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr bool operator!=(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
 	return a.upper != b.upper || a.lower != b.lower;
 }
 
 template <typename TYPE>
-bool operator<(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr bool operator<(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
 	return a.upper < b.upper || (a.upper == b.upper && a.lower < b.lower);
 }
 
 template <typename TYPE>
-bool operator>(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr bool operator>(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
 	return a.upper > b.upper || (a.upper == b.upper && a.lower > b.lower);
 }
 
 template <typename TYPE>
-bool operator<=(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr bool operator<=(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
 	return a.upper < b.upper || (a.upper == b.upper && a.lower <= b.lower);
 }
 
 template <typename TYPE>
-bool operator>=(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr bool operator>=(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
 	return a.upper > b.upper || (a.upper == b.upper && a.lower >= b.lower);
 }
 
 template <typename TYPE>
-TwoInt<TYPE> operator~(TwoInt<TYPE> a)
+constexpr TwoInt<TYPE> operator~(const TwoInt<TYPE> &a)
 {
 	TwoInt<TYPE> tmp;
 	tmp.lower = ~a.lower;
@@ -301,35 +575,44 @@ TwoInt<TYPE> operator~(TwoInt<TYPE> a)
 }
 
 template <typename TYPE>
-TwoInt<TYPE> operator|(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr TwoInt<TYPE> operator|(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
-	TwoInt<TYPE> tmp;
-	tmp.lower = a.lower | b.lower;
-	tmp.upper = a.upper | b.upper;
+	TwoInt<TYPE> tmp = a;
+	tmp |= b;
 	return tmp;
 }
 
 template <typename TYPE>
-TwoInt<TYPE> operator&(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr TwoInt<TYPE> operator&(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
-	TwoInt<TYPE> tmp;
-	tmp.lower = a.lower & b.lower;
-	tmp.upper = a.upper & b.upper;
+	TwoInt<TYPE> tmp = a;
+	tmp &= b;
 	return tmp;
 }
 
 template <typename TYPE>
-TwoInt<TYPE> operator^(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr TwoInt<TYPE> operator^(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
-	TwoInt<TYPE> tmp;
-	tmp.lower = a.lower ^ b.lower;
-	tmp.upper = a.upper ^ b.upper;
+	TwoInt<TYPE> tmp = a;
+	tmp ^= b;
 	return tmp;
 }
 
+template <typename WIDE, typename TYPE>
+constexpr WIDE widen(const TYPE &a)
+{
+	auto bytes = std::bit_cast<std::array<uint8_t, sizeof(TYPE)>>(a);
+	std::array<uint8_t, sizeof(WIDE)> tmp = {};
+	for (size_t i = 0; i < bytes.size(); ++i)
+		tmp[i] = bytes[i];
+	return std::bit_cast<WIDE>(tmp);
+}
+
 template <typename TYPE>
-TwoInt<TYPE> operator>>(TwoInt<TYPE> a, int i)
+constexpr TwoInt<TYPE> operator>>(TwoInt<TYPE> a, int i)
 {
+	if constexpr (sizeof(TYPE) % sizeof(uint64_t) == 0)
+		return a >>= i;
 	if (i == 0)
 		return a;
 	TwoInt<TYPE> tmp;
@@ -344,8 +627,10 @@ TwoInt<TYPE> operator>>(TwoInt<TYPE> a, int i)
 }
 
 template <typename TYPE>
-TwoInt<TYPE> operator<<(TwoInt<TYPE> a, int i)
+constexpr TwoInt<TYPE> operator<<(TwoInt<TYPE> a, int i)
 {
+	if constexpr (sizeof(TYPE) % sizeof(uint64_t) == 0)
+		return a <<= i;
 	if (i == 0)
 		return a;
 	TwoInt<TYPE> tmp;
@@ -360,211 +645,826 @@ TwoInt<TYPE> operator<<(TwoInt<TYPE> a, int i)
 }
 
 template <typename TYPE>
-TwoInt<TYPE> operator+(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr TwoInt<TYPE> operator+(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
-	TwoInt<TYPE> tmp;
-	tmp.lower = a.lower + b.lower;
-	tmp.upper = a.upper + b.upper;
-	if (tmp.lower < a.lower)
-		++tmp.upper;
+	TwoInt<TYPE> tmp = a;
+	tmp += b;
 	return tmp;
 }
 
 template <typename TYPE>
-TwoInt<TYPE> operator-(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr bool add_to(TwoInt<TYPE> &a, const TwoInt<TYPE> &b, bool carry)
 {
-	TwoInt<TYPE> tmp;
-	tmp.lower = a.lower - b.lower;
-	tmp.upper = a.upper - b.upper;
-	if (tmp.lower > a.lower)
-		--tmp.upper;
+	carry = add_to(a.lower, b.lower, carry);
+	return add_to(a.upper, b.upper, carry);
+}
+
+template <typename TYPE, typename OTHER>
+constexpr bool add_shifted(TwoInt<TYPE> &a, const TwoInt<OTHER> &b, int k)
+{
+	static_assert(sizeof(b) <= sizeof(a), "addend must not be wider than the sum");
+	if constexpr (std::is_same<TYPE, TwoInt<OTHER>>::value) {
+		if (k == int(sizeof(OTHER) * 8)) {
+			bool carry = add_to(a.lower.upper, b.lower, false);
+			carry = add_to(a.upper.lower, b.upper, carry);
+			if (carry)
+				carry = !++a.upper.upper;
+			return carry;
+		}
+	}
+	if constexpr (sizeof(b) % sizeof(uint64_t)) {
+		return add_to(a, widen<TwoInt<TYPE>>(b) << k, false);
+	} else {
+		auto x = std::bit_cast<std::array<uint64_t, sizeof(a) / sizeof(uint64_t)>>(a);
+		auto y = std::bit_cast<std::array<uint64_t, sizeof(b) / sizeof(uint64_t)>>(b);
+		bool carry = add_limbs_shifted(x.data(), x.size(), y.data(), y.size(), k);
+		a = std::bit_cast<TwoInt<TYPE>>(x);
+		return carry;
+	}
+}
+
+#ifdef __SIZEOF_INT128__
+constexpr TwoInt<uint64_t> operator+(TwoInt<uint64_t> a, TwoInt<uint64_t> b)
+{
+	unsigned __int128 x = (unsigned __int128)a.upper << 64 | a.lower;
+	unsigned __int128 y = (unsigned __int128)b.upper << 64 | b.lower;
+	unsigned __int128 z = x + y;
+	TwoInt<uint64_t> tmp;
+	tmp.lower = z;
+	tmp.upper = z >> 64;
 	return tmp;
 }
+#endif
 
 template <typename TYPE>
-TwoInt<TYPE> operator*(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr TwoInt<TYPE> operator-(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
-	TwoInt<TYPE> middle = mul(a.lower, b.upper) + mul(a.upper, b.lower);
-	int h = sizeof(TYPE) * 8;
-	return mul(a.lower, b.lower) + (middle << h);
+	TwoInt<TYPE> tmp = a;
+	tmp -= b;
+	return tmp;
+}
+
+template <typename TYPE>
+constexpr bool sub_from(TwoInt<TYPE> &a, const TwoInt<TYPE> &b, bool borrow)
+{
+	borrow = sub_from(a.lower, b.lower, borrow);
+	return sub_from(a.upper, b.upper, borrow);
+}
+
+template <typename TYPE, typename OTHER>
+constexpr bool sub_shifted(TwoInt<TYPE> &a, const TwoInt<OTHER> &b, int k)
+{
+	static_assert(sizeof(b) <= sizeof(a), "subtrahend must not be wider than the difference");
+	if constexpr (std::is_same<TYPE, TwoInt<OTHER>>::value) {
+		if (k == int(sizeof(OTHER) * 8)) {
+			bool borrow = sub_from(a.lower.upper, b.lower, false);
+			borrow = sub_from(a.upper.lower, b.upper, borrow);
+			if (borrow) {
+				borrow = !a.upper.upper;
+				--a.upper.upper;
+			}
+			return borrow;
+		}
+	}
+	if constexpr (sizeof(b) % sizeof(uint64_t)) {
+		return sub_from(a, widen<TwoInt<TYPE>>(b) << k, false);
+	} else {
+		auto x = std::bit_cast<std::array<uint64_t, sizeof(a) / sizeof(uint64_t)>>(a);
+		auto y = std::bit_cast<std::array<uint64_t, sizeof(b) / sizeof(uint64_t)>>(b);
+		bool borrow = sub_limbs_shifted(x.data(), x.size(), y.data(), y.size(), k);
+		a = std::bit_cast<TwoInt<TYPE>>(x);
+		return borrow;
+	}
+}
+
+#ifdef __SIZEOF_INT128__
+constexpr TwoInt<uint64_t> operator-(TwoInt<uint64_t> a, TwoInt<uint64_t> b)
+{
+	unsigned __int128 x = (unsigned __int128)a.upper << 64 | a.lower;
+	unsigned __int128 y = (unsigned __int128)b.upper << 64 | b.lower;
+	unsigned __int128 z = x - y;
+	TwoInt<uint64_t> tmp;
+	tmp.lower = z;
+	tmp.upper = z >> 64;
+	return tmp;
 }
+#endif
 
-TwoInt<uint8_t> operator*(TwoInt<uint8_t> a, TwoInt<uint8_t> b)
+template <typename TYPE>
+constexpr TwoInt<TYPE> operator*(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
-	uint16_t tmp = *reinterpret_cast<uint16_t *>(&a) * *reinterpret_cast<uint16_t *>(&b);
-	return *reinterpret_cast<TwoInt<uint8_t> *>(&tmp);
+	TwoInt<TYPE> tmp = mul(a.lower, b.lower);
+	tmp.upper += a.lower * b.upper + a.upper * b.lower;
+	return tmp;
 }
 
-TwoInt<uint16_t> operator*(TwoInt<uint16_t> a, TwoInt<uint16_t> b)
+constexpr TwoInt<uint8_t> operator*(TwoInt<uint8_t> a, TwoInt<uint8_t> b)
 {
-	uint32_t tmp = *reinterpret_cast<uint32_t *>(&a) * *reinterpret_cast<uint32_t *>(&b);
-	return *reinterpret_cast<TwoInt<uint16_t> *>(&tmp);
+	uint16_t tmp = unsigned(pack(a)) * pack(b);
+	return TwoInt<uint8_t>(tmp);
 }
 
-TwoInt<uint32_t> operator*(TwoInt<uint32_t> a, TwoInt<uint32_t> b)
+constexpr TwoInt<uint16_t> operator*(TwoInt<uint16_t> a, TwoInt<uint16_t> b)
 {
-	uint64_t tmp = *reinterpret_cast<uint64_t *>(&a) * *reinterpret_cast<uint64_t *>(&b);
-	return *reinterpret_cast<TwoInt<uint32_t> *>(&tmp);
+	uint32_t tmp = pack(a) * pack(b);
+	return TwoInt<uint16_t>(tmp);
+}
+
+constexpr TwoInt<uint32_t> operator*(TwoInt<uint32_t> a, TwoInt<uint32_t> b)
+{
+	uint64_t tmp = pack(a) * pack(b);
+	return TwoInt<uint32_t>(tmp);
+}
+
+#ifdef __SIZEOF_INT128__
+constexpr TwoInt<uint64_t> operator*(TwoInt<uint64_t> a, TwoInt<uint64_t> b)
+{
+	unsigned __int128 lower = (unsigned __int128)a.lower * b.lower;
+	TwoInt<uint64_t> tmp;
+	tmp.lower = lower;
+	tmp.upper = (lower >> 64) + a.lower * b.upper + a.upper * b.lower;
+	return tmp;
+}
+#endif
+
+template <typename TYPE>
+constexpr TwoInt<TwoInt<TYPE>> karatsuba(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
+{
+	bool cx, cy;
+	TYPE x = add_carry(a.lower, a.upper, false, &cx);
+	TYPE y = add_carry(b.lower, b.upper, false, &cy);
+	TwoInt<TwoInt<TYPE>> tmp;
+	tmp.lower = mul(a.lower, b.lower);
+	tmp.upper = mul(a.upper, b.upper);
+	TwoInt<TYPE> middle = mul(x, y);
+	int carry = cx && cy;
+	if (cx)
+		carry += add_to(middle.upper, y, false);
+	if (cy)
+		carry += add_to(middle.upper, x, false);
+	carry -= sub_from(middle, tmp.lower, false);
+	carry -= sub_from(middle, tmp.upper, false);
+	int h = sizeof(TYPE) * 8;
+	add_shifted(tmp, middle, h);
+	if (carry)
+		++tmp.upper.upper;
+	return tmp;
 }
 
 template <typename TYPE>
-TwoInt<TwoInt<TYPE>> mul(TwoInt<TYPE> a, TwoInt<TYPE> b)
+constexpr TwoInt<TwoInt<TYPE>> mul(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b)
 {
-	TwoInt<TYPE> middle;
-	middle = mul(a.lower, b.upper) + mul(a.upper, b.lower);
+	if (sizeof(a) * 8 >= KARATSUBA_THRESHOLD)
+		return karatsuba(a, b);
 	int h = sizeof(TYPE) * 8;
-	TwoInt<TYPE> lower = middle << h;
-	TwoInt<TYPE> upper = middle >> h;
 	TwoInt<TwoInt<TYPE>> tmp;
-	tmp.lower = mul(a.lower, b.lower) + lower;
-	tmp.upper = mul(a.upper, b.upper) + upper;
-	if (tmp.lower < lower)
-		++tmp.upper;
+	tmp.lower = mul(a.lower, b.lower);
+	tmp.upper = mul(a.upper, b.upper);
+	add_shifted(tmp, mul(a.lower, b.upper), h);
+	add_shifted(tmp, mul(a.upper, b.lower), h);
 	return tmp;
 }
 
 template <>
-TwoInt<TwoInt<uint8_t>> mul(TwoInt<uint8_t> a, TwoInt<uint8_t> b)
+constexpr TwoInt<TwoInt<uint8_t>> mul(const TwoInt<uint8_t> &a, const TwoInt<uint8_t> &b)
 {
-	uint32_t tmp = uint32_t(*reinterpret_cast<uint16_t *>(&a)) * uint32_t(*reinterpret_cast<uint16_t *>(&b));
-	return *reinterpret_cast<TwoInt<TwoInt<uint8_t>> *>(&tmp);
+	uint32_t tmp = uint32_t(pack(a)) * uint32_t(pack(b));
+	return TwoInt<TwoInt<uint8_t>>(tmp);
 }
 
 template <>
-TwoInt<TwoInt<uint16_t>> mul(TwoInt<uint16_t> a, TwoInt<uint16_t> b)
+constexpr TwoInt<TwoInt<uint16_t>> mul(const TwoInt<uint16_t> &a, const TwoInt<uint16_t> &b)
 {
-	uint64_t tmp = uint64_t(*reinterpret_cast<uint32_t *>(&a)) * uint64_t(*reinterpret_cast<uint32_t *>(&b));
-	return *reinterpret_cast<TwoInt<TwoInt<uint16_t>> *>(&tmp);
+	uint64_t tmp = uint64_t(pack(a)) * uint64_t(pack(b));
+	return TwoInt<TwoInt<uint16_t>>(tmp);
 }
 
 template <>
-TwoInt<TwoInt<uint32_t>> mul(TwoInt<uint32_t> a, TwoInt<uint32_t> b)
+constexpr TwoInt<TwoInt<uint32_t>> mul(const TwoInt<uint32_t> &a, const TwoInt<uint32_t> &b)
 {
-	uint64_t middle = uint64_t(a.lower) * uint64_t(b.upper) + uint64_t(a.upper) * uint64_t(b.lower);
+	uint64_t cross = uint64_t(a.upper) * uint64_t(b.lower);
+	uint64_t middle = uint64_t(a.lower) * uint64_t(b.upper) + cross;
 	uint64_t lower = uint64_t(a.lower) * uint64_t(b.lower) + (middle << 32);
 	uint64_t upper = uint64_t(a.upper) * uint64_t(b.upper) + (middle >> 32);
 	if (lower < (middle << 32))
 		++upper;
+	if (middle < cross)
+		upper += uint64_t(1) << 32;
 	TwoInt<TwoInt<uint32_t>> tmp;
-	tmp.lower = *reinterpret_cast<TwoInt<uint32_t> *>(&lower);
-	tmp.upper = *reinterpret_cast<TwoInt<uint32_t> *>(&upper);
+	tmp.lower = TwoInt<uint32_t>(lower);
+	tmp.upper = TwoInt<uint32_t>(upper);
+	return tmp;
+}
+
+#ifdef __SIZEOF_INT128__
+template <>
+constexpr TwoInt<TwoInt<uint64_t>> mul(const TwoInt<uint64_t> &a, const TwoInt<uint64_t> &b)
+{
+	unsigned __int128 ll = (unsigned __int128)a.lower * b.lower;
+	unsigned __int128 lu = (unsigned __int128)a.lower * b.upper;
+	unsigned __int128 ul = (unsigned __int128)a.upper * b.lower;
+	unsigned __int128 uu = (unsigned __int128)a.upper * b.upper;
+	unsigned __int128 middle = (ll >> 64) + uint64_t(lu) + uint64_t(ul);
+	unsigned __int128 upper = uu + (lu >> 64) + (ul >> 64) + (middle >> 64);
+	TwoInt<TwoInt<uint64_t>> tmp;
+	tmp.lower.lower = ll;
+	tmp.lower.upper = middle;
+	tmp.upper.lower = upper;
+	tmp.upper.upper = upper >> 64;
 	return tmp;
 }
+#endif
 
 template <typename TYPE>
-TwoInt<TYPE> operator/(TwoInt<TYPE> dividend, TwoInt<TYPE> divisor)
+constexpr TwoInt<TwoInt<TYPE>> sqr(const TwoInt<TYPE> &a)
 {
-	assert(divisor);
-	TwoInt<TYPE> quotient;
-	for (int shift = sizeof(quotient) * 8 - 1; shift >= 0; --shift) {
-		if ((dividend >> shift) >= divisor) {
-			dividend -= divisor << shift;
-			quotient.set(shift);
+	int h = sizeof(TYPE) * 8;
+	TwoInt<TwoInt<TYPE>> tmp;
+	tmp.lower = sqr(a.lower);
+	tmp.upper = sqr(a.upper);
+	if (sizeof(a) * 8 >= KARATSUBA_THRESHOLD) {
+		bool cx;
+		TYPE x = add_carry(a.lower, a.upper, false, &cx);
+		int carry = cx;
+		TwoInt<TYPE> middle = sqr(x);
+		if (cx) {
+			carry += add_to(middle.upper, x, false);
+			carry += add_to(middle.upper, x, false);
 		}
+		carry -= sub_from(middle, tmp.lower, false);
+		carry -= sub_from(middle, tmp.upper, false);
+		add_shifted(tmp, middle, h);
+		if (carry)
+			++tmp.upper.upper;
+	} else {
+		TwoInt<TYPE> middle = mul(a.lower, a.upper);
+		bool carry = add_to(middle, middle, false);
+		add_shifted(tmp, middle, h);
+		if (carry)
+			++tmp.upper.upper;
 	}
-	return quotient;
+	return tmp;
+}
+
+template <>
+constexpr TwoInt<TwoInt<uint8_t>> sqr(const TwoInt<uint8_t> &a)
+{
+	return mul(a, a);
 }
 
-TwoInt<uint8_t> operator/(TwoInt<uint8_t> a, TwoInt<uint8_t> b)
+template <>
+constexpr TwoInt<TwoInt<uint16_t>> sqr(const TwoInt<uint16_t> &a)
 {
-	uint16_t tmp = *reinterpret_cast<uint16_t *>(&a) / *reinterpret_cast<uint16_t *>(&b);
-	return *reinterpret_cast<TwoInt<uint8_t> *>(&tmp);
+	return mul(a, a);
 }
 
-TwoInt<uint16_t> operator/(TwoInt<uint16_t> a, TwoInt<uint16_t> b)
+template <>
+constexpr TwoInt<TwoInt<uint32_t>> sqr(const TwoInt<uint32_t> &a)
 {
-	uint32_t tmp = *reinterpret_cast<uint32_t *>(&a) / *reinterpret_cast<uint32_t *>(&b);
-	return *reinterpret_cast<TwoInt<uint16_t> *>(&tmp);
+	uint64_t cross = uint64_t(a.lower) * uint64_t(a.upper);
+	uint64_t lower = uint64_t(a.lower) * uint64_t(a.lower) + (cross << 33);
+	uint64_t upper = uint64_t(a.upper) * uint64_t(a.upper) + (cross >> 31);
+	if (lower < (cross << 33))
+		++upper;
+	TwoInt<TwoInt<uint32_t>> tmp;
+	tmp.lower = TwoInt<uint32_t>(lower);
+	tmp.upper = TwoInt<uint32_t>(upper);
+	return tmp;
 }
 
-TwoInt<uint32_t> operator/(TwoInt<uint32_t> a, TwoInt<uint32_t> b)
+#ifdef __SIZEOF_INT128__
+template <>
+constexpr TwoInt<TwoInt<uint64_t>> sqr(const TwoInt<uint64_t> &a)
 {
-	uint64_t tmp = *reinterpret_cast<uint64_t *>(&a) / *reinterpret_cast<uint64_t *>(&b);
-	return *reinterpret_cast<TwoInt<uint32_t> *>(&tmp);
+	unsigned __int128 ll = (unsigned __int128)a.lower * a.lower;
+	unsigned __int128 lu = (unsigned __int128)a.lower * a.upper;
+	unsigned __int128 uu = (unsigned __int128)a.upper * a.upper;
+	unsigned __int128 middle = (ll >> 64) + ((unsigned __int128)uint64_t(lu) << 1);
+	unsigned __int128 upper = uu + ((lu >> 64) << 1) + (middle >> 64);
+	TwoInt<TwoInt<uint64_t>> tmp;
+	tmp.lower.lower = ll;
+	tmp.lower.upper = middle;
+	tmp.upper.lower = upper;
+	tmp.upper.upper = upper >> 64;
+	return tmp;
 }
+#endif
 
 template <typename TYPE>
-TwoInt<TYPE> operator%(TwoInt<TYPE> dividend, TwoInt<TYPE> divisor)
+constexpr TwoInt<TYPE> mulhi(const TwoInt<TYPE> &a, const TwoInt<TYPE> &b, int shift = 0)
 {
-	assert(divisor);
-	TwoInt<TYPE> quotient;
-	for (int shift = sizeof(quotient) * 8 - 1; shift >= 0; --shift)
-		if ((dividend >> shift) >= divisor)
-			dividend -= divisor << shift;
-	return dividend;
+	int h = sizeof(TYPE) * 8;
+	assert(shift >= 0 && shift < h);
+	if (sizeof(a) * 8 >= KARATSUBA_THRESHOLD) {
+		TwoInt<TwoInt<TYPE>> tmp = mul(a, b);
+		if (shift)
+			return (tmp.upper << shift) | (tmp.lower >> (2 * h - shift));
+		return tmp.upper;
+	}
+	TwoInt<TYPE> cross = mul(a.upper, b.lower);
+	TwoInt<TYPE> middle = mul(a.lower, b.upper);
+	TwoInt<TYPE> tmp = mul(a.upper, b.upper);
+	TYPE below = mulhi(a.lower, b.lower);
+	bool carry = add_to(below, middle.lower, false);
+	if (add_to(tmp.lower, middle.upper, carry))
+		++tmp.upper;
+	carry = add_to(below, cross.lower, false);
+	if (add_to(tmp.lower, cross.upper, carry))
+		++tmp.upper;
+	if (shift) {
+		tmp <<= shift;
+		tmp.lower |= below >> (h - shift);
+	}
+	return tmp;
+}
+
+template <typename TYPE>
+constexpr TwoInt<TYPE> sqrhi(const TwoInt<TYPE> &a, int shift = 0)
+{
+	int h = sizeof(TYPE) * 8;
+	assert(shift >= 0 && shift < h);
+	if (sizeof(a) * 8 >= KARATSUBA_THRESHOLD) {
+		TwoInt<TwoInt<TYPE>> tmp = sqr(a);
+		if (shift)
+			return (tmp.upper << shift) | (tmp.lower >> (2 * h - shift));
+		return tmp.upper;
+	}
+	TwoInt<TYPE> middle = mul(a.lower, a.upper);
+	bool top = add_to(middle, middle, false);
+	TwoInt<TYPE> tmp = sqr(a.upper);
+	TYPE below = sqrhi(a.lower);
+	bool carry = add_to(below, middle.lower, false);
+	if (add_to(tmp.lower, middle.upper, carry))
+		++tmp.upper;
+	if (top)
+		++tmp.upper;
+	if (shift) {
+		tmp <<= shift;
+		tmp.lower |= below >> (h - shift);
+	}
+	return tmp;
+}
+
+constexpr TwoInt<uint8_t> mulhi(TwoInt<uint8_t> a, TwoInt<uint8_t> b, int shift = 0)
+{
+	TwoInt<TwoInt<uint8_t>> tmp = mul(a, b);
+	if (shift)
+		return (tmp.upper << shift) | (tmp.lower >> (16 - shift));
+	return tmp.upper;
+}
+
+constexpr TwoInt<uint16_t> mulhi(TwoInt<uint16_t> a, TwoInt<uint16_t> b, int shift = 0)
+{
+	TwoInt<TwoInt<uint16_t>> tmp = mul(a, b);
+	if (shift)
+		return (tmp.upper << shift) | (tmp.lower >> (32 - shift));
+	return tmp.upper;
+}
+
+constexpr TwoInt<uint32_t> mulhi(TwoInt<uint32_t> a, TwoInt<uint32_t> b, int shift = 0)
+{
+	TwoInt<TwoInt<uint32_t>> tmp = mul(a, b);
+	if (shift)
+		return (tmp.upper << shift) | (tmp.lower >> (64 - shift));
+	return tmp.upper;
+}
+
+#ifdef __SIZEOF_INT128__
+constexpr TwoInt<uint64_t> mulhi(TwoInt<uint64_t> a, TwoInt<uint64_t> b, int shift = 0)
+{
+	TwoInt<TwoInt<uint64_t>> tmp = mul(a, b);
+	if (shift)
+		return (tmp.upper << shift) | (tmp.lower >> (128 - shift));
+	return tmp.upper;
 }
+#endif
 
-TwoInt<uint8_t> operator%(TwoInt<uint8_t> a, TwoInt<uint8_t> b)
+constexpr TwoInt<uint8_t> sqrhi(TwoInt<uint8_t> a, int shift = 0)
 {
-	uint16_t tmp = *reinterpret_cast<uint16_t *>(&a) % *reinterpret_cast<uint16_t *>(&b);
-	return *reinterpret_cast<TwoInt<uint8_t> *>(&tmp);
+	TwoInt<TwoInt<uint8_t>> tmp = sqr(a);
+	if (shift)
+		return (tmp.upper << shift) | (tmp.lower >> (16 - shift));
+	return tmp.upper;
 }
 
-TwoInt<uint16_t> operator%(TwoInt<uint16_t> a, TwoInt<uint16_t> b)
+constexpr TwoInt<uint16_t> sqrhi(TwoInt<uint16_t> a, int shift = 0)
 {
-	uint32_t tmp = *reinterpret_cast<uint32_t *>(&a) % *reinterpret_cast<uint32_t *>(&b);
-	return *reinterpret_cast<TwoInt<uint16_t> *>(&tmp);
+	TwoInt<TwoInt<uint16_t>> tmp = sqr(a);
+	if (shift)
+		return (tmp.upper << shift) | (tmp.lower >> (32 - shift));
+	return tmp.upper;
 }
 
-TwoInt<uint32_t> operator%(TwoInt<uint32_t> a, TwoInt<uint32_t> b)
+constexpr TwoInt<uint32_t> sqrhi(TwoInt<uint32_t> a, int shift = 0)
 {
-	uint64_t tmp = *reinterpret_cast<uint64_t *>(&a) % *reinterpret_cast<uint64_t *>(&b);
-	return *reinterpret_cast<TwoInt<uint32_t> *>(&tmp);
+	TwoInt<TwoInt<uint32_t>> tmp = sqr(a);
+	if (shift)
+		return (tmp.upper << shift) | (tmp.lower >> (64 - shift));
+	return tmp.upper;
 }
 
+#ifdef __SIZEOF_INT128__
+constexpr TwoInt<uint64_t> sqrhi(TwoInt<uint64_t> a, int shift = 0)
+{
+	TwoInt<TwoInt<uint64_t>> tmp = sqr(a);
+	if (shift)
+		return (tmp.upper << shift) | (tmp.lower >> (128 - shift));
+	return tmp.upper;
+}
+#endif
+
+template <typename DIGIT>
+struct WideDigit;
+
+template <>
+struct WideDigit<uint32_t>
+{
+	typedef uint64_t type;
+};
+
+#ifdef __SIZEOF_INT128__
+template <>
+struct WideDigit<uint64_t>
+{
+	typedef unsigned __int128 type;
+};
+#endif
+
 template <typename TYPE>
-TwoInt<TwoInt<TYPE>> div(TwoInt<TYPE> dividend, TwoInt<TYPE> divisor)
+struct LongDigit
 {
-	assert(divisor);
-	TwoInt<TYPE> quotient, remainder;
-	for (int shift = sizeof(quotient) * 8 - 1; shift >= 0; --shift) {
-		remainder <<= 1;
-		if (dividend.get(shift))
-			remainder.set(0);
-		if (remainder >= divisor) {
-			remainder -= divisor;
-			quotient.set(shift);
+#ifdef __SIZEOF_INT128__
+	typedef typename std::conditional<sizeof(TYPE) % 8 == 0, uint64_t, uint32_t>::type type;
+#else
+	typedef uint32_t type;
+#endif
+};
+
+template <typename TYPE>
+struct Digits
+{
+	typedef typename LongDigit<TYPE>::type DIGIT;
+	static const int LENGTH = (sizeof(TYPE) + 7) / 8 * 8 / sizeof(DIGIT);
+	DIGIT digit[LENGTH];
+	constexpr Digits() : digit() {}
+	constexpr Digits(const TYPE &a) : digit()
+	{
+		if constexpr (sizeof(TYPE) % sizeof(DIGIT) == 0) {
+			auto tmp = std::bit_cast<std::array<DIGIT, sizeof(TYPE) / sizeof(DIGIT)>>(a);
+			for (size_t i = 0; i < tmp.size(); ++i)
+				digit[i] = tmp[i];
+		} else {
+			auto tmp = std::bit_cast<std::array<uint8_t, sizeof(TYPE)>>(a);
+			for (size_t i = 0; i < tmp.size(); ++i)
+				digit[i / sizeof(DIGIT)] |= DIGIT(tmp[i]) << (8 * (i % sizeof(DIGIT)));
+		}
+	}
+	constexpr Digits(uint64_t a) : digit()
+	{
+		for (size_t i = 0; i < sizeof(a) / sizeof(DIGIT); ++i)
+			digit[i] = a >> (8 * sizeof(DIGIT) * i);
+	}
+	constexpr TYPE value() const
+	{
+		if constexpr (sizeof(TYPE) % sizeof(DIGIT) == 0) {
+			std::array<DIGIT, sizeof(TYPE) / sizeof(DIGIT)> tmp;
+			for (size_t i = 0; i < tmp.size(); ++i)
+				tmp[i] = digit[i];
+			return std::bit_cast<TYPE>(tmp);
+		} else {
+			std::array<uint8_t, sizeof(TYPE)> tmp;
+			for (size_t i = 0; i < tmp.size(); ++i)
+				tmp[i] = digit[i / sizeof(DIGIT)] >> (8 * (i % sizeof(DIGIT)));
+			return std::bit_cast<TYPE>(tmp);
 		}
 	}
+	constexpr uint64_t scalar() const
+	{
+		uint64_t tmp = 0;
+		for (size_t i = 0; i < sizeof(tmp) / sizeof(DIGIT); ++i)
+			tmp |= uint64_t(digit[i]) << (8 * sizeof(DIGIT) * i);
+		return tmp;
+	}
+};
+
+constexpr int leading_zeros(uint32_t a)
+{
+	return __builtin_clz(a);
+}
+
+constexpr int leading_zeros(uint64_t a)
+{
+	return __builtin_clzll(a);
+}
+
+constexpr uint32_t divide(uint32_t upper, uint32_t lower, uint32_t divisor, uint32_t *remainder)
+{
+	uint64_t dividend = uint64_t(upper) << 32 | lower;
+	*remainder = dividend % divisor;
+	return dividend / divisor;
+}
+
+#ifdef __SIZEOF_INT128__
+constexpr uint64_t divide(uint64_t upper, uint64_t lower, uint64_t divisor, uint64_t *remainder)
+{
+#ifdef __x86_64__
+	if (!std::is_constant_evaluated()) {
+		uint64_t quotient;
+		__asm__ ("divq %4" : "=a" (quotient), "=d" (*remainder) : "a" (lower), "d" (upper), "rm" (divisor));
+		return quotient;
+	}
+#endif
+	unsigned __int128 dividend = (unsigned __int128)upper << 64 | lower;
+	*remainder = dividend % divisor;
+	return dividend / divisor;
+}
+#endif
+
+template <typename DIGIT, typename DIVIDE>
+constexpr void normalized_division(DIGIT *quotient, DIGIT *un, const DIGIT *vn, int m, int n, DIVIDE divide)
+{
+	typedef typename WideDigit<DIGIT>::type WIDE;
+	const int D = sizeof(DIGIT) * 8;
+	for (int j = m - n; j >= 0; --j) {
+		DIGIT qhat, rhat;
+		bool overflow = false;
+		if (un[j + n] >= vn[n - 1]) {
+			qhat = ~DIGIT(0);
+			rhat = un[j + n - 1] + vn[n - 1];
+			overflow = rhat < vn[n - 1];
+		} else {
+			qhat = divide(un[j + n], un[j + n - 1], &rhat);
+		}
+		while (!overflow && WIDE(qhat) * vn[n - 2] > (WIDE(rhat) << D | un[j + n - 2])) {
+			--qhat;
+			rhat += vn[n - 1];
+			overflow = rhat < vn[n - 1];
+		}
+		DIGIT carry = 0;
+		bool borrow = false;
+		for (int i = 0; i < n; ++i) {
+			WIDE prod = WIDE(qhat) * vn[i] + carry;
+			carry = prod >> D;
+			borrow = sub_from(un[i + j], DIGIT(prod), borrow);
+		}
+		if (sub_from(un[j + n], carry, borrow)) {
+			--qhat;
+			bool overflow = false;
+			for (int i = 0; i < n; ++i)
+				overflow = add_to(un[i + j], vn[i], overflow);
+			un[j + n] += overflow;
+		}
+		quotient[j] = qhat;
+	}
+}
+
+template <typename DIGIT, int LENGTH>
+constexpr void long_division(DIGIT *quotient, DIGIT *remainder, const DIGIT *dividend, const DIGIT *divisor, int m, int n)
+{
+	const int D = sizeof(DIGIT) * 8;
+	assert(n);
+	for (int i = 0; i < LENGTH; ++i)
+		quotient[i] = remainder[i] = 0;
+	if (m < n) {
+		for (int i = 0; i < m; ++i)
+			remainder[i] = dividend[i];
+		return;
+	}
+	if (n == 1) {
+		DIGIT rem = 0;
+		for (int j = m - 1; j >= 0; --j)
+			quotient[j] = divide(rem, dividend[j], divisor[0], &rem);
+		remainder[0] = rem;
+		return;
+	}
+	int s = leading_zeros(divisor[n - 1]);
+	DIGIT vn[LENGTH], un[LENGTH + 1];
+	for (int i = n - 1; i > 0; --i)
+		vn[i] = divisor[i] << s | (s ? divisor[i - 1] >> (D - s) : 0);
+	vn[0] = divisor[0] << s;
+	un[m] = s ? dividend[m - 1] >> (D - s) : 0;
+	for (int i = m - 1; i > 0; --i)
+		un[i] = dividend[i] << s | (s ? dividend[i - 1] >> (D - s) : 0);
+	un[0] = dividend[0] << s;
+	normalized_division(quotient, un, vn, m, n, [top = vn[n - 1]](DIGIT upper, DIGIT lower, DIGIT *rem) { return divide(upper, lower, top, rem); });
+	for (int i = 0; i < n - 1; ++i)
+		remainder[i] = un[i] >> s | (s ? un[i + 1] << (D - s) : 0);
+	remainder[n - 1] = un[n - 1] >> s;
+}
+
+template <typename TYPE>
+constexpr TwoInt<TYPE> operator/(const TwoInt<TYPE> &dividend, const TwoInt<TYPE> &divisor)
+{
+	return div(dividend, divisor).lower;
+}
+
+constexpr TwoInt<uint8_t> operator/(TwoInt<uint8_t> a, TwoInt<uint8_t> b)
+{
+	uint16_t tmp = pack(a) / pack(b);
+	return TwoInt<uint8_t>(tmp);
+}
+
+constexpr TwoInt<uint16_t> operator/(TwoInt<uint16_t> a, TwoInt<uint16_t> b)
+{
+	uint32_t tmp = pack(a) / pack(b);
+	return TwoInt<uint16_t>(tmp);
+}
+
+constexpr TwoInt<uint32_t> operator/(TwoInt<uint32_t> a, TwoInt<uint32_t> b)
+{
+	uint64_t tmp = pack(a) / pack(b);
+	return TwoInt<uint32_t>(tmp);
+}
+
+#ifdef __SIZEOF_INT128__
+constexpr TwoInt<uint64_t> operator/(TwoInt<uint64_t> a, TwoInt<uint64_t> b)
+{
+	unsigned __int128 x = (unsigned __int128)a.upper << 64 | a.lower;
+	unsigned __int128 y = (unsigned __int128)b.upper << 64 | b.lower;
+	unsigned __int128 z = x / y;
+	TwoInt<uint64_t> tmp;
+	tmp.lower = z;
+	tmp.upper = z >> 64;
+	return tmp;
+}
+#endif
+
+template <typename TYPE>
+constexpr TwoInt<TYPE> operator%(const TwoInt<TYPE> &dividend, const TwoInt<TYPE> &divisor)
+{
+	return div(dividend, divisor).upper;
+}
+
+constexpr TwoInt<uint8_t> operator%(TwoInt<uint8_t> a, TwoInt<uint8_t> b)
+{
+	uint16_t tmp = pack(a) % pack(b);
+	return TwoInt<uint8_t>(tmp);
+}
+
+constexpr TwoInt<uint16_t> operator%(TwoInt<uint16_t> a, TwoInt<uint16_t> b)
+{
+	uint32_t tmp = pack(a) % pack(b);
+	return TwoInt<uint16_t>(tmp);
+}
+
+constexpr TwoInt<uint32_t> operator%(TwoInt<uint32_t> a, TwoInt<uint32_t> b)
+{
+	uint64_t tmp = pack(a) % pack(b);
+	return TwoInt<uint32_t>(tmp);
+}
+
+#ifdef __SIZEOF_INT128__
+constexpr TwoInt<uint64_t> operator%(TwoInt<uint64_t> a, TwoInt<uint64_t> b)
+{
+	unsigned __int128 x = (unsigned __int128)a.upper << 64 | a.lower;
+	unsigned __int128 y = (unsigned __int128)b.upper << 64 | b.lower;
+	unsigned __int128 z = x % y;
+	TwoInt<uint64_t> tmp;
+	tmp.lower = z;
+	tmp.upper = z >> 64;
+	return tmp;
+}
+#endif
+
+template <typename TYPE>
+constexpr TwoInt<TwoInt<TYPE>> div(const TwoInt<TYPE> &dividend, const TwoInt<TYPE> &divisor)
+{
+	assert(divisor);
+	typedef Digits<TwoInt<TYPE>> DIGITS;
+	const int D = sizeof(typename DIGITS::DIGIT) * 8;
+	DIGITS u(dividend), v(divisor), q, r;
+	long_division<typename DIGITS::DIGIT, DIGITS::LENGTH>(q.digit, r.digit, u.digit, v.digit, (bit_width(dividend) + D - 1) / D, (bit_width(divisor) + D - 1) / D);
 	TwoInt<TwoInt<TYPE>> tmp;
-	tmp.lower = quotient;
-	tmp.upper = remainder;
+	tmp.lower = q.value();
+	tmp.upper = r.value();
 	return tmp;
 }
 
-TwoInt<TwoInt<uint8_t>> div(TwoInt<uint8_t> a, TwoInt<uint8_t> b)
+constexpr TwoInt<TwoInt<uint8_t>> div(TwoInt<uint8_t> a, TwoInt<uint8_t> b)
 {
-	uint16_t x = *reinterpret_cast<uint16_t *>(&a);
-	uint16_t y = *reinterpret_cast<uint16_t *>(&b);
+	uint16_t x = pack(a);
+	uint16_t y = pack(b);
 	uint16_t q = x / y;
 	uint16_t r = x % y;
 	TwoInt<TwoInt<uint8_t>> tmp;
-	tmp.lower = *reinterpret_cast<TwoInt<uint8_t> *>(&q);
-	tmp.upper = *reinterpret_cast<TwoInt<uint8_t> *>(&r);
+	tmp.lower = TwoInt<uint8_t>(q);
+	tmp.upper = TwoInt<uint8_t>(r);
 	return tmp;
 }
 
-TwoInt<TwoInt<uint16_t>> div(TwoInt<uint16_t> a, TwoInt<uint16_t> b)
+constexpr TwoInt<TwoInt<uint16_t>> div(TwoInt<uint16_t> a, TwoInt<uint16_t> b)
 {
-	uint32_t x = *reinterpret_cast<uint32_t *>(&a);
-	uint32_t y = *reinterpret_cast<uint32_t *>(&b);
+	uint32_t x = pack(a);
+	uint32_t y = pack(b);
 	uint32_t q = x / y;
 	uint32_t r = x % y;
 	TwoInt<TwoInt<uint16_t>> tmp;
-	tmp.lower = *reinterpret_cast<TwoInt<uint16_t> *>(&q);
-	tmp.upper = *reinterpret_cast<TwoInt<uint16_t> *>(&r);
+	tmp.lower = TwoInt<uint16_t>(q);
+	tmp.upper = TwoInt<uint16_t>(r);
 	return tmp;
 }
 
-TwoInt<TwoInt<uint32_t>> div(TwoInt<uint32_t> a, TwoInt<uint32_t> b)
+constexpr TwoInt<TwoInt<uint32_t>> div(TwoInt<uint32_t> a, TwoInt<uint32_t> b)
 {
-	uint64_t x = *reinterpret_cast<uint64_t *>(&a);
-	uint64_t y = *reinterpret_cast<uint64_t *>(&b);
+	uint64_t x = pack(a);
+	uint64_t y = pack(b);
 	uint64_t q = x / y;
 	uint64_t r = x % y;
 	TwoInt<TwoInt<uint32_t>> tmp;
-	tmp.lower = *reinterpret_cast<TwoInt<uint32_t> *>(&q);
-	tmp.upper = *reinterpret_cast<TwoInt<uint32_t> *>(&r);
+	tmp.lower = TwoInt<uint32_t>(q);
+	tmp.upper = TwoInt<uint32_t>(r);
 	return tmp;
 }
 
+#ifdef __SIZEOF_INT128__
+constexpr TwoInt<TwoInt<uint64_t>> div(TwoInt<uint64_t> a, TwoInt<uint64_t> b)
+{
+	unsigned __int128 x = (unsigned __int128)a.upper << 64 | a.lower;
+	unsigned __int128 y = (unsigned __int128)b.upper << 64 | b.lower;
+	unsigned __int128 q = x / y;
+	unsigned __int128 r = x % y;
+	TwoInt<TwoInt<uint64_t>> tmp;
+	tmp.lower.lower = q;
+	tmp.lower.upper = q >> 64;
+	tmp.upper.lower = r;
+	tmp.upper.upper = r >> 64;
+	return tmp;
+}
+#endif
+
+template <typename TYPE>
+constexpr TwoInt<TYPE> operator+(const TwoInt<TYPE> &a, uint64_t b)
+{
+	typedef Digits<TwoInt<TYPE>> DIGITS;
+	typedef typename DIGITS::DIGIT DIGIT;
+	DIGITS x(a), y(b);
+	bool carry = false;
+	for (int i = 0; i < DIGITS::LENGTH; ++i) {
+		if (!carry && i * sizeof(DIGIT) >= sizeof(b))
+			break;
+		carry = add_to(x.digit[i], y.digit[i], carry);
+	}
+	return x.value();
+}
+
+template <typename TYPE>
+constexpr TwoInt<TYPE> operator-(const TwoInt<TYPE> &a, uint64_t b)
+{
+	typedef Digits<TwoInt<TYPE>> DIGITS;
+	typedef typename DIGITS::DIGIT DIGIT;
+	DIGITS x(a), y(b);
+	bool borrow = false;
+	for (int i = 0; i < DIGITS::LENGTH; ++i) {
+		if (!borrow && i * sizeof(DIGIT) >= sizeof(b))
+			break;
+		borrow = sub_from(x.digit[i], y.digit[i], borrow);
+	}
+	return x.value();
+}
+
+template <typename TYPE>
+constexpr TwoInt<TYPE> operator*(const TwoInt<TYPE> &a, uint64_t b)
+{
+	typedef Digits<TwoInt<TYPE>> DIGITS;
+	typedef typename DIGITS::DIGIT DIGIT;
+	typedef typename WideDigit<DIGIT>::type WIDE;
+	const int D = sizeof(DIGIT) * 8;
+	const int K = sizeof(b) / sizeof(DIGIT);
+	DIGITS x(a), y(b), z;
+	for (int k = 0; k < K; ++k) {
+		DIGIT carry = 0;
+		for (int i = 0; i + k < DIGITS::LENGTH; ++i) {
+			WIDE prod = WIDE(x.digit[i]) * y.digit[k] + z.digit[i + k] + carry;
+			z.digit[i + k] = prod;
+			carry = prod >> D;
+		}
+	}
+	return z.value();
+}
+
+template <typename TYPE>
+constexpr TwoInt<TYPE> divmod(const TwoInt<TYPE> &dividend, uint64_t divisor, uint64_t *remainder)
+{
+	assert(divisor);
+	typedef Digits<TwoInt<TYPE>> DIGITS;
+	const int D = sizeof(typename DIGITS::DIGIT) * 8;
+	DIGITS u(dividend), v(divisor), q, r;
+	long_division<typename DIGITS::DIGIT, DIGITS::LENGTH>(q.digit, r.digit, u.digit, v.digit, (bit_width(dividend) + D - 1) / D, (std::bit_width(divisor) + D - 1) / D);
+	if (remainder)
+		*remainder = r.scalar();
+	return q.value();
+}
+
+template <typename TYPE>
+constexpr TwoInt<TYPE> operator/(const TwoInt<TYPE> &dividend, uint64_t divisor)
+{
+	return divmod(dividend, divisor, nullptr);
+}
+
+template <typename TYPE>
+constexpr uint64_t operator%(const TwoInt<TYPE> &dividend, uint64_t divisor)
+{
+	uint64_t remainder;
+	divmod(dividend, divisor, &remainder);
+	return remainder;
+}
@@ -0,0 +1,285 @@
+/*
+Structure of arrays batch of unsigned integers
+
+Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
+*/
+
+#pragma once
+
+#include <bit>
+#include <array>
+#include <cstdint>
+#include "two_int.hh"
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+template <typename TYPE, int LANES>
+struct TwoIntBatch
+{
+	static_assert(sizeof(TYPE) % sizeof(uint32_t) == 0, "TYPE must be a multiple of 32 bits");
+	static const int LIMBS = sizeof(TYPE) / sizeof(uint32_t);
+	alignas(64) uint32_t limb[LIMBS][LANES];
+	TwoIntBatch() : limb() {}
+	void insert(int lane, TYPE value)
+	{
+		auto tmp = std::bit_cast<std::array<uint32_t, LIMBS>>(value);
+		for (int i = 0; i < LIMBS; ++i)
+			limb[i][lane] = tmp[i];
+	}
+	TYPE extract(int lane) const
+	{
+		std::array<uint32_t, LIMBS> tmp;
+		for (int i = 0; i < LIMBS; ++i)
+			tmp[i] = limb[i][lane];
+		return std::bit_cast<TYPE>(tmp);
+	}
+};
+
+template <int LANES>
+void batch_add(uint32_t *sum, uint32_t *carry, const uint32_t *a, const uint32_t *b)
+{
+	int l = 0;
+#ifdef __AVX512F__
+	for (; l + 16 <= LANES; l += 16) {
+		__m512i x = _mm512_loadu_si512(a + l);
+		__m512i y = _mm512_loadu_si512(b + l);
+		__m512i c = _mm512_loadu_si512(carry + l);
+		__m512i s = _mm512_add_epi32(_mm512_add_epi32(x, y), c);
+		__mmask16 k = _mm512_cmplt_epu32_mask(s, x) | (_mm512_cmpeq_epi32_mask(s, x) & _mm512_test_epi32_mask(c, c));
+		_mm512_storeu_si512(sum + l, s);
+		_mm512_storeu_si512(carry + l, _mm512_maskz_set1_epi32(k, 1));
+	}
+#endif
+#ifdef __AVX2__
+	for (; l + 8 <= LANES; l += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)(a + l));
+		__m256i y = _mm256_loadu_si256((const __m256i *)(b + l));
+		__m256i c = _mm256_loadu_si256((const __m256i *)(carry + l));
+		__m256i s = _mm256_add_epi32(_mm256_add_epi32(x, y), c);
+		__m256i bias = _mm256_set1_epi32(0x80000000);
+		__m256i xb = _mm256_xor_si256(x, bias), sb = _mm256_xor_si256(s, bias);
+		__m256i lt = _mm256_cmpgt_epi32(xb, sb);
+		__m256i eq = _mm256_and_si256(_mm256_cmpeq_epi32(s, x), _mm256_cmpeq_epi32(c, _mm256_set1_epi32(1)));
+		c = _mm256_srli_epi32(_mm256_or_si256(lt, eq), 31);
+		_mm256_storeu_si256((__m256i *)(sum + l), s);
+		_mm256_storeu_si256((__m256i *)(carry + l), c);
+	}
+#endif
+	for (; l < LANES; ++l) {
+		uint64_t tmp = uint64_t(a[l]) + b[l] + carry[l];
+		sum[l] = tmp;
+		carry[l] = tmp >> 32;
+	}
+}
+
+template <int LANES>
+void batch_sub(uint32_t *diff, uint32_t *borrow, const uint32_t *a, const uint32_t *b)
+{
+	int l = 0;
+#ifdef __AVX512F__
+	for (; l + 16 <= LANES; l += 16) {
+		__m512i x = _mm512_loadu_si512(a + l);
+		__m512i y = _mm512_loadu_si512(b + l);
+		__m512i c = _mm512_loadu_si512(borrow + l);
+		__m512i d = _mm512_sub_epi32(_mm512_sub_epi32(x, y), c);
+		__mmask16 k = _mm512_cmpgt_epu32_mask(d, x) | (_mm512_cmpeq_epi32_mask(d, x) & _mm512_test_epi32_mask(c, c));
+		_mm512_storeu_si512(diff + l, d);
+		_mm512_storeu_si512(borrow + l, _mm512_maskz_set1_epi32(k, 1));
+	}
+#endif
+#ifdef __AVX2__
+	for (; l + 8 <= LANES; l += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)(a + l));
+		__m256i y = _mm256_loadu_si256((const __m256i *)(b + l));
+		__m256i c = _mm256_loadu_si256((const __m256i *)(borrow + l));
+		__m256i d = _mm256_sub_epi32(_mm256_sub_epi32(x, y), c);
+		__m256i bias = _mm256_set1_epi32(0x80000000);
+		__m256i xb = _mm256_xor_si256(x, bias), db = _mm256_xor_si256(d, bias);
+		__m256i gt = _mm256_cmpgt_epi32(db, xb);
+		__m256i eq = _mm256_and_si256(_mm256_cmpeq_epi32(d, x), _mm256_cmpeq_epi32(c, _mm256_set1_epi32(1)));
+		c = _mm256_srli_epi32(_mm256_or_si256(gt, eq), 31);
+		_mm256_storeu_si256((__m256i *)(diff + l), d);
+		_mm256_storeu_si256((__m256i *)(borrow + l), c);
+	}
+#endif
+	for (; l < LANES; ++l) {
+		uint64_t tmp = uint64_t(a[l]) - b[l] - borrow[l];
+		diff[l] = tmp;
+		borrow[l] = (tmp >> 32) & 1;
+	}
+}
+
+template <int LANES>
+void batch_mac(uint32_t *acc, uint32_t *carry, const uint32_t *a, const uint32_t *b)
+{
+	int l = 0;
+#ifdef __AVX512F__
+	for (; l + 16 <= LANES; l += 16) {
+		__m512i x = _mm512_loadu_si512(a + l);
+		__m512i y = _mm512_loadu_si512(b + l);
+		__m512i r = _mm512_loadu_si512(acc + l);
+		__m512i c = _mm512_loadu_si512(carry + l);
+		__m512i mask = _mm512_set1_epi64(0xffffffff);
+		__m512i even = _mm512_maskz_mul_epu32(0xff, x, y);
+		__m512i odd = _mm512_maskz_mul_epu32(0xff, _mm512_maskz_srli_epi64(0xff, x, 32), _mm512_maskz_srli_epi64(0xff, y, 32));
+		even = _mm512_add_epi64(even, _mm512_and_si512(r, mask));
+		odd = _mm512_add_epi64(odd, _mm512_maskz_srli_epi64(0xff, r, 32));
+		even = _mm512_add_epi64(even, _mm512_and_si512(c, mask));
+		odd = _mm512_add_epi64(odd, _mm512_maskz_srli_epi64(0xff, c, 32));
+		r = _mm512_mask_blend_epi32(0xaaaa, even, _mm512_maskz_slli_epi64(0xff, odd, 32));
+		c = _mm512_mask_blend_epi32(0xaaaa, _mm512_maskz_srli_epi64(0xff, even, 32), odd);
+		_mm512_storeu_si512(acc + l, r);
+		_mm512_storeu_si512(carry + l, c);
+	}
+#endif
+#ifdef __AVX2__
+	for (; l + 8 <= LANES; l += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)(a + l));
+		__m256i y = _mm256_loadu_si256((const __m256i *)(b + l));
+		__m256i r = _mm256_loadu_si256((const __m256i *)(acc + l));
+		__m256i c = _mm256_loadu_si256((const __m256i *)(carry + l));
+		__m256i mask = _mm256_set1_epi64x(0xffffffff);
+		__m256i even = _mm256_mul_epu32(x, y);
+		__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32));
+		even = _mm256_add_epi64(even, _mm256_and_si256(r, mask));
+		odd = _mm256_add_epi64(odd, _mm256_srli_epi64(r, 32));
+		even = _mm256_add_epi64(even, _mm256_and_si256(c, mask));
+		odd = _mm256_add_epi64(odd, _mm256_srli_epi64(c, 32));
+		r = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+		c = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+		_mm256_storeu_si256((__m256i *)(acc + l), r);
+		_mm256_storeu_si256((__m256i *)(carry + l), c);
+	}
+#endif
+	for (; l < LANES; ++l) {
+		uint64_t tmp = uint64_t(a[l]) * b[l] + acc[l] + carry[l];
+		acc[l] = tmp;
+		carry[l] = tmp >> 32;
+	}
+}
+
+template <typename TYPE, int LANES>
+TwoIntBatch<TYPE, LANES> operator+(const TwoIntBatch<TYPE, LANES> &a, const TwoIntBatch<TYPE, LANES> &b)
+{
+	const int LIMBS = TwoIntBatch<TYPE, LANES>::LIMBS;
+	TwoIntBatch<TYPE, LANES> tmp;
+	alignas(64) uint32_t carry[LANES] = { 0 };
+	for (int i = 0; i < LIMBS; ++i)
+		batch_add<LANES>(tmp.limb[i], carry, a.limb[i], b.limb[i]);
+	return tmp;
+}
+
+template <typename TYPE, int LANES>
+TwoIntBatch<TYPE, LANES> operator-(const TwoIntBatch<TYPE, LANES> &a, const TwoIntBatch<TYPE, LANES> &b)
+{
+	const int LIMBS = TwoIntBatch<TYPE, LANES>::LIMBS;
+	TwoIntBatch<TYPE, LANES> tmp;
+	alignas(64) uint32_t borrow[LANES] = { 0 };
+	for (int i = 0; i < LIMBS; ++i)
+		batch_sub<LANES>(tmp.limb[i], borrow, a.limb[i], b.limb[i]);
+	return tmp;
+}
+
+template <typename TYPE, int LANES>
+TwoIntBatch<TYPE, LANES> operator<<(const TwoIntBatch<TYPE, LANES> &a, int n)
+{
+	const int LIMBS = TwoIntBatch<TYPE, LANES>::LIMBS;
+	TwoIntBatch<TYPE, LANES> tmp;
+	int w = n / 32, b = n % 32;
+	for (int i = LIMBS - 1; i >= w; --i)
+		for (int l = 0; l < LANES; ++l)
+			tmp.limb[i][l] = a.limb[i - w][l] << b | (b && i > w ? a.limb[i - w - 1][l] >> (32 - b) : 0);
+	return tmp;
+}
+
+template <typename TYPE, int LANES>
+TwoIntBatch<TYPE, LANES> operator>>(const TwoIntBatch<TYPE, LANES> &a, int n)
+{
+	const int LIMBS = TwoIntBatch<TYPE, LANES>::LIMBS;
+	TwoIntBatch<TYPE, LANES> tmp;
+	int w = n / 32, b = n % 32;
+	for (int i = 0; i + w < LIMBS; ++i)
+		for (int l = 0; l < LANES; ++l)
+			tmp.limb[i][l] = a.limb[i + w][l] >> b | (b && i + w + 1 < LIMBS ? a.limb[i + w + 1][l] << (32 - b) : 0);
+	return tmp;
+}
+
+template <typename TYPE, int LANES>
+std::array<bool, LANES> operator<(const TwoIntBatch<TYPE, LANES> &a, const TwoIntBatch<TYPE, LANES> &b)
+{
+	const int LIMBS = TwoIntBatch<TYPE, LANES>::LIMBS;
+	std::array<bool, LANES> less, equal;
+	for (int l = 0; l < LANES; ++l) {
+		less[l] = false;
+		equal[l] = true;
+	}
+	for (int i = LIMBS - 1; i >= 0; --i) {
+		for (int l = 0; l < LANES; ++l) {
+			less[l] |= equal[l] & (a.limb[i][l] < b.limb[i][l]);
+			equal[l] &= a.limb[i][l] == b.limb[i][l];
+		}
+	}
+	return less;
+}
+
+template <typename TYPE, int LANES>
+std::array<bool, LANES> operator>(const TwoIntBatch<TYPE, LANES> &a, const TwoIntBatch<TYPE, LANES> &b)
+{
+	return b < a;
+}
+
+template <typename TYPE, int LANES>
+std::array<bool, LANES> operator==(const TwoIntBatch<TYPE, LANES> &a, const TwoIntBatch<TYPE, LANES> &b)
+{
+	const int LIMBS = TwoIntBatch<TYPE, LANES>::LIMBS;
+	std::array<bool, LANES> equal;
+	for (int l = 0; l < LANES; ++l)
+		equal[l] = true;
+	for (int i = 0; i < LIMBS; ++i)
+		for (int l = 0; l < LANES; ++l)
+			equal[l] &= a.limb[i][l] == b.limb[i][l];
+	return equal;
+}
+
+template <typename TYPE, int LANES>
+TwoIntBatch<TwoInt<TYPE>, LANES> mul(const TwoIntBatch<TYPE, LANES> &a, const TwoIntBatch<TYPE, LANES> &b)
+{
+	const int LIMBS = TwoIntBatch<TYPE, LANES>::LIMBS;
+	TwoIntBatch<TwoInt<TYPE>, LANES> tmp;
+	for (int i = 0; i < LIMBS; ++i) {
+		alignas(64) uint32_t carry[LANES] = { 0 };
+		for (int j = 0; j < LIMBS; ++j)
+			batch_mac<LANES>(tmp.limb[i + j], carry, a.limb[i], b.limb[j]);
+		for (int l = 0; l < LANES; ++l)
+			tmp.limb[i + LIMBS][l] = carry[l];
+	}
+	return tmp;
+}
+
+template <typename TYPE, int LANES>
+TwoIntBatch<TYPE, LANES> operator*(const TwoIntBatch<TYPE, LANES> &a, const TwoIntBatch<TYPE, LANES> &b)
+{
+	const int LIMBS = TwoIntBatch<TYPE, LANES>::LIMBS;
+	TwoIntBatch<TYPE, LANES> tmp;
+	for (int i = 0; i < LIMBS; ++i) {
+		alignas(64) uint32_t carry[LANES] = { 0 };
+		for (int j = 0; i + j < LIMBS; ++j)
+			batch_mac<LANES>(tmp.limb[i + j], carry, a.limb[i], b.limb[j]);
+	}
+	return tmp;
+}
+
+template <typename TYPE, int LANES>
+TwoIntBatch<TYPE, LANES> mulhi(const TwoIntBatch<TYPE, LANES> &a, const TwoIntBatch<TYPE, LANES> &b, int shift = 0)
+{
+	const int LIMBS = TwoIntBatch<TYPE, LANES>::LIMBS;
+	TwoIntBatch<TwoInt<TYPE>, LANES> prod = mul(a, b);
+	if (shift)
+		prod = prod << shift;
+	TwoIntBatch<TYPE, LANES> tmp;
+	for (int i = 0; i < LIMBS; ++i)
+		for (int l = 0; l < LANES; ++l)
+			tmp.limb[i][l] = prod.limb[i + LIMBS][l];
+	return tmp;
+}
@@ -0,0 +1,266 @@
+/*
+Decimal and hexadecimal conversion of unsigned integers
+
+Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
+*/
+
+#pragma once
+
+#include <bit>
+#include <array>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <charconv>
+#include <istream>
+#include <ostream>
+#include <algorithm>
+#include <system_error>
+#include "two_int.hh"
+#include "flat_int.hh"
+
+struct CharsTables
+{
+	char decimal[200];
+	char hex[512];
+	uint8_t value[256];
+	constexpr CharsTables() : decimal(), hex(), value()
+	{
+		for (int i = 0; i < 100; ++i) {
+			decimal[2 * i] = '0' + i / 10;
+			decimal[2 * i + 1] = '0' + i % 10;
+		}
+		for (int i = 0; i < 256; ++i) {
+			hex[2 * i] = "0123456789abcdef"[i >> 4];
+			hex[2 * i + 1] = "0123456789abcdef"[i & 15];
+			value[i] = 255;
+		}
+		for (int i = 0; i < 10; ++i)
+			value['0' + i] = i;
+		for (int i = 0; i < 6; ++i)
+			value['a' + i] = value['A' + i] = 10 + i;
+	}
+};
+
+inline constexpr CharsTables chars_tables;
+
+template <typename TYPE>
+constexpr int max_decimal_digits()
+{
+	return sizeof(TYPE) * 8 * 1233 / 4096 + 1;
+}
+
+template <typename TYPE>
+constexpr int decimal_levels()
+{
+	int levels = 0;
+	while (19 << levels < max_decimal_digits<TYPE>())
+		++levels;
+	return levels;
+}
+
+template <typename TYPE>
+constexpr std::array<TYPE, decimal_levels<TYPE>()> make_decimal_powers()
+{
+	std::array<TYPE, decimal_levels<TYPE>()> powers;
+	powers[0] = TYPE(10000000000000000000ULL);
+	for (int k = 1; k < decimal_levels<TYPE>(); ++k)
+		powers[k] = powers[k - 1] * powers[k - 1];
+	return powers;
+}
+
+template <typename TYPE>
+inline constexpr auto decimal_powers = make_decimal_powers<TYPE>();
+
+inline void decimal_chunk(char *last, uint64_t value)
+{
+	for (int i = 0; i < 9; ++i, value /= 100)
+		std::copy_n(chars_tables.decimal + 2 * (value % 100), 2, last -= 2);
+	last[-1] = '0' + value;
+}
+
+template <typename TYPE>
+void decimal_split(char *last, const TYPE &value, int k)
+{
+	if (k < 0) {
+		decimal_chunk(last, std::bit_cast<std::array<uint64_t, sizeof(TYPE) / 8>>(value)[0]);
+		return;
+	}
+	if (!value) {
+		std::fill(last - (38 << k), last, '0');
+		return;
+	}
+	auto tmp = div(value, decimal_powers<TYPE>[k]);
+	decimal_split(last, tmp.upper, k - 1);
+	decimal_split(last - (19 << k), tmp.lower, k - 1);
+}
+
+template <typename TYPE>
+std::to_chars_result integer_to_chars(char *first, char *last, const TYPE &value, int base)
+{
+	const int BYTES = sizeof(TYPE);
+	char buffer[BYTES <= 8 ? 20 : 19 << decimal_levels<TYPE>()];
+	char *end = buffer + sizeof(buffer), *begin = end;
+	if (base == 16) {
+		auto bytes = std::bit_cast<std::array<uint8_t, BYTES>>(value);
+		int n = BYTES;
+		while (n > 1 && !bytes[n - 1])
+			--n;
+		for (int i = 0; i < n; ++i)
+			std::copy_n(chars_tables.hex + 2 * bytes[i], 2, begin -= 2);
+		if (*begin == '0' && begin + 1 < end)
+			++begin;
+	} else if constexpr (BYTES <= 8) {
+		typedef std::conditional_t<BYTES == 2, uint16_t, std::conditional_t<BYTES == 4, uint32_t, uint64_t>> NATIVE;
+		begin = buffer;
+		end = std::to_chars(buffer, end, std::bit_cast<NATIVE>(value)).ptr;
+	} else {
+		int digits = (bit_width(value) * 1233 >> 12) + 1, k = -1;
+		while (19 << (k + 1) < digits)
+			++k;
+		begin = end - (19 << (k + 1));
+		decimal_split(end, value, k);
+		while (*begin == '0' && begin + 1 < end)
+			++begin;
+	}
+	if (last - first < end - begin)
+		return { last, std::errc::value_too_large };
+	return { std::copy(begin, end, first), std::errc() };
+}
+
+template <typename TYPE>
+std::from_chars_result integer_from_chars(const char *first, const char *last, TYPE &value, int base)
+{
+	const int BITS = sizeof(TYPE) * 8;
+	const int LIMBS = (sizeof(TYPE) + 7) / 8;
+	const char *end = first;
+	while (end < last && chars_tables.value[uint8_t(*end)] < base)
+		++end;
+	if (end == first)
+		return { first, std::errc::invalid_argument };
+	std::array<uint64_t, LIMBS> limb = {};
+	bool overflow = false;
+	const char *digit = first;
+	while (digit + 1 < end && *digit == '0')
+		++digit;
+	if (base == 16) {
+		overflow = 4 * (end - digit) > BITS;
+		for (const char *p = end; !overflow && p > digit; --p) {
+			int i = end - p;
+			limb[i / 16] |= uint64_t(chars_tables.value[uint8_t(p[-1])]) << 4 * (i % 16);
+		}
+	} else {
+		for (int used = 0; !overflow && digit < end;) {
+			int length = std::min<int>(19, end - digit);
+			uint64_t chunk = 0, scale = 1;
+			for (int i = 0; i < length; ++i, ++digit, scale *= 10)
+				chunk = chunk * 10 + chars_tables.value[uint8_t(*digit)];
+			uint64_t carry = chunk;
+			for (int i = 0; i < used; ++i) {
+#ifdef __SIZEOF_INT128__
+				unsigned __int128 prod = (unsigned __int128)limb[i] * scale + carry;
+				limb[i] = prod;
+				carry = prod >> 64;
+#else
+				auto prod = std::bit_cast<std::array<uint64_t, 2>>(mul(TwoInt<uint32_t>(limb[i]), TwoInt<uint32_t>(scale)) + carry);
+				limb[i] = prod[0];
+				carry = prod[1];
+#endif
+			}
+			if (carry && used < LIMBS)
+				limb[used++] = carry;
+			else if (carry)
+				overflow = true;
+		}
+	}
+	if (BITS % 64 && limb[LIMBS - 1] >> (BITS % 64))
+		overflow = true;
+	if (overflow)
+		return { end, std::errc::result_out_of_range };
+	auto bytes = std::bit_cast<std::array<uint8_t, 8 * LIMBS>>(limb);
+	std::array<uint8_t, sizeof(TYPE)> tmp;
+	std::copy_n(bytes.begin(), tmp.size(), tmp.begin());
+	value = std::bit_cast<TYPE>(tmp);
+	return { end, std::errc() };
+}
+
+template <typename TYPE>
+std::to_chars_result to_chars(char *first, char *last, const TwoInt<TYPE> &value, int base = 10)
+{
+	return integer_to_chars(first, last, value, base);
+}
+
+#ifdef __SIZEOF_INT128__
+template <int BITS>
+std::to_chars_result to_chars(char *first, char *last, const FlatInt<BITS> &value, int base = 10)
+{
+	return integer_to_chars(first, last, value, base);
+}
+#endif
+
+template <typename TYPE>
+std::from_chars_result from_chars(const char *first, const char *last, TwoInt<TYPE> &value, int base = 10)
+{
+	return integer_from_chars(first, last, value, base);
+}
+
+#ifdef __SIZEOF_INT128__
+template <int BITS>
+std::from_chars_result from_chars(const char *first, const char *last, FlatInt<BITS> &value, int base = 10)
+{
+	return integer_from_chars(first, last, value, base);
+}
+#endif
+
+template <typename TYPE>
+std::ostream &integer_write(std::ostream &os, const TYPE &value)
+{
+	char buffer[max_decimal_digits<TYPE>()];
+	int base = (os.flags() & std::ios_base::basefield) == std::ios_base::hex ? 16 : 10;
+	auto result = integer_to_chars(buffer, buffer + sizeof(buffer), value, base);
+	return os << std::string_view(buffer, result.ptr - buffer);
+}
+
+template <typename TYPE>
+std::istream &integer_read(std::istream &is, TYPE &value)
+{
+	int base = (is.flags() & std::ios_base::basefield) == std::ios_base::hex ? 16 : 10;
+	std::string digits;
+	std::istream::sentry sentry(is);
+	if (sentry) {
+		while (chars_tables.value[uint8_t(is.peek())] < base)
+			digits.push_back(is.get());
+	}
+	auto result = integer_from_chars(digits.data(), digits.data() + digits.size(), value, base);
+	if (result.ec != std::errc())
+		is.setstate(std::ios_base::failbit);
+	return is;
+}
+
+template <typename TYPE>
+std::ostream &operator<<(std::ostream &os, const TwoInt<TYPE> &value)
+{
+	return integer_write(os, value);
+}
+
+#ifdef __SIZEOF_INT128__
+template <int BITS>
+std::ostream &operator<<(std::ostream &os, const FlatInt<BITS> &value)
+{
+	return integer_write(os, value);
+}
+#endif
+
+template <typename TYPE>
+std::istream &operator>>(std::istream &is, TwoInt<TYPE> &value)
+{
+	return integer_read(is, value);
+}
+
+#ifdef __SIZEOF_INT128__
+template <int BITS>
+std::istream &operator>>(std::istream &is, FlatInt<BITS> &value)
+{
+	return integer_read(is, value);
+}
+#endif
@@ -0,0 +1,113 @@
+/*
+Division by a constant divisor with a precomputed reciprocal
+
+Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
+*/
+
+#pragma once
+
+#include <bit>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include "two_int.hh"
+
+#ifdef __SIZEOF_INT128__
+constexpr uint64_t reciprocal_word(uint64_t divisor)
+{
+	uint64_t remainder;
+	return divide(~divisor, ~uint64_t(0), divisor, &remainder);
+}
+
+constexpr uint64_t divide(uint64_t upper, uint64_t lower, uint64_t divisor, uint64_t reciprocal, uint64_t *remainder)
+{
+	unsigned __int128 q = (unsigned __int128)reciprocal * upper + ((unsigned __int128)(upper + 1) << 64 | lower);
+	uint64_t quotient = q >> 64, rem = lower - quotient * divisor;
+	uint64_t mask = -uint64_t(rem > uint64_t(q));
+	quotient += mask;
+	rem += mask & divisor;
+	if (rem >= divisor) [[unlikely]] {
+		++quotient;
+		rem -= divisor;
+	}
+	*remainder = rem;
+	return quotient;
+}
+
+template <typename TYPE>
+struct Divider
+{
+	static const int LIMBS = (sizeof(TYPE) + 7) / 8;
+	typedef std::array<uint64_t, LIMBS> Limbs;
+	TYPE divisor;
+	Limbs normalized;
+	uint64_t reciprocal;
+	int length, shift;
+	constexpr Divider(const TYPE &divisor) : divisor(divisor), normalized(), reciprocal(0), length(0), shift(0)
+	{
+		assert(divisor != TYPE(0));
+		if constexpr (sizeof(TYPE) % 8 == 0 && sizeof(TYPE) > 16) {
+			int width = bit_width(divisor);
+			length = (width + 63) / 64;
+			shift = 64 * length - width;
+			normalized = std::bit_cast<Limbs>(divisor << shift);
+			reciprocal = reciprocal_word(normalized[length - 1]);
+		}
+	}
+	constexpr TYPE divide(const TYPE &dividend, TYPE *remainder) const
+	{
+		if constexpr (sizeof(TYPE) % 8 || sizeof(TYPE) <= 16) {
+			if (remainder)
+				*remainder = dividend % divisor;
+			return dividend / divisor;
+		} else {
+			return long_division(dividend, remainder);
+		}
+	}
+	constexpr TYPE long_division(const TYPE &dividend, TYPE *remainder) const
+	{
+		const int n = length, s = shift;
+		const uint64_t *vn = normalized.data();
+		Limbs u = std::bit_cast<Limbs>(dividend), q = {}, r = {};
+		int m = (bit_width(dividend) + 63) / 64;
+		if (m < n) {
+			if (remainder)
+				*remainder = dividend;
+			return TYPE(0);
+		}
+		if (n == 1) {
+			uint64_t rem = s ? u[m - 1] >> (64 - s) : 0;
+			for (int j = m - 1; j >= 0; --j)
+				q[j] = ::divide(rem, u[j] << s | (s && j ? u[j - 1] >> (64 - s) : 0), vn[0], reciprocal, &rem);
+			r[0] = rem >> s;
+		} else {
+			uint64_t un[LIMBS + 1];
+			un[m] = s ? u[m - 1] >> (64 - s) : 0;
+			for (int i = m - 1; i > 0; --i)
+				un[i] = u[i] << s | (s ? u[i - 1] >> (64 - s) : 0);
+			un[0] = u[0] << s;
+			normalized_division(q.data(), un, vn, m, n, [top = vn[n - 1], reciprocal = reciprocal](uint64_t upper, uint64_t lower, uint64_t *rem) { return ::divide(upper, lower, top, reciprocal, rem); });
+			for (int i = 0; i < n - 1; ++i)
+				r[i] = un[i] >> s | (s ? un[i + 1] << (64 - s) : 0);
+			r[n - 1] = un[n - 1] >> s;
+		}
+		if (remainder)
+			*remainder = std::bit_cast<TYPE>(r);
+		return std::bit_cast<TYPE>(q);
+	}
+};
+
+template <typename TYPE>
+constexpr TYPE operator/(const TYPE &dividend, const Divider<TYPE> &divider)
+{
+	return divider.divide(dividend, nullptr);
+}
+
+template <typename TYPE>
+constexpr TYPE operator%(const TYPE &dividend, const Divider<TYPE> &divider)
+{
+	TYPE remainder;
+	divider.divide(dividend, &remainder);
+	return remainder;
+}
+#endif
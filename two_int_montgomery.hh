@@ -0,0 +1,189 @@
+/*
+Montgomery modular multiplication and exponentiation
+
+Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
+*/
+
+#pragma once
+
+#include <bit>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include "two_int.hh"
+
+#ifdef __SIZEOF_INT128__
+template <typename TYPE, bool CONSTANT_TIME = false>
+struct MontgomeryContext
+{
+	static_assert(sizeof(TYPE) % sizeof(uint64_t) == 0, "TYPE must be a multiple of 64 bits");
+	static const int LIMBS = sizeof(TYPE) / sizeof(uint64_t);
+	static const int BITS = 64 * LIMBS;
+	typedef std::array<uint64_t, LIMBS> Limbs;
+	typedef unsigned __int128 WIDE;
+	TYPE modulus, one, r2;
+	uint64_t minv;
+	constexpr MontgomeryContext(const TYPE &modulus) : modulus(modulus)
+	{
+		Limbs n = std::bit_cast<Limbs>(modulus);
+		assert(n[0] & 1);
+		uint64_t inv = n[0];
+		for (int i = 0; i < 5; ++i)
+			inv *= 2 - n[0] * inv;
+		minv = -inv;
+		one = (TYPE(0) - modulus) % modulus;
+		TwoInt<TYPE> wide = mul(one, one), m;
+		m.lower = modulus;
+		r2 = (wide % m).lower;
+	}
+	constexpr Limbs reduce(Limbs t, bool carry) const
+	{
+		Limbs n = std::bit_cast<Limbs>(modulus), d;
+		bool borrow = false;
+		for (int j = 0; j < LIMBS; ++j) {
+			d[j] = t[j];
+			borrow = sub_from(d[j], n[j], borrow);
+		}
+		if constexpr (CONSTANT_TIME) {
+			uint64_t mask = -uint64_t(carry | !borrow);
+			for (int j = 0; j < LIMBS; ++j)
+				t[j] = (d[j] & mask) | (t[j] & ~mask);
+			return t;
+		}
+		return carry || !borrow ? d : t;
+	}
+	constexpr TYPE redc(std::array<uint64_t, 2 * LIMBS> t) const
+	{
+		Limbs n = std::bit_cast<Limbs>(modulus), r;
+		uint64_t extra = 0;
+		for (int i = 0; i < LIMBS; ++i) {
+			uint64_t m = t[i] * minv, carry = 0;
+			for (int j = 0; j < LIMBS; ++j) {
+				WIDE p = WIDE(m) * n[j] + t[i + j] + carry;
+				t[i + j] = p;
+				carry = p >> 64;
+			}
+			WIDE s = WIDE(t[i + LIMBS]) + carry + extra;
+			t[i + LIMBS] = s;
+			extra = s >> 64;
+		}
+		for (int j = 0; j < LIMBS; ++j)
+			r[j] = t[j + LIMBS];
+		return std::bit_cast<TYPE>(reduce(r, extra));
+	}
+	constexpr TYPE cios(const TYPE &a, const TYPE &b) const
+	{
+		Limbs x = std::bit_cast<Limbs>(a), y = std::bit_cast<Limbs>(b), n = std::bit_cast<Limbs>(modulus);
+		uint64_t t[LIMBS + 2] = { 0 };
+		for (int i = 0; i < LIMBS; ++i) {
+			uint64_t carry = 0;
+			for (int j = 0; j < LIMBS; ++j) {
+				WIDE p = WIDE(x[j]) * y[i] + t[j] + carry;
+				t[j] = p;
+				carry = p >> 64;
+			}
+			WIDE s = WIDE(t[LIMBS]) + carry;
+			t[LIMBS] = s;
+			t[LIMBS + 1] = s >> 64;
+			uint64_t m = t[0] * minv;
+			carry = (WIDE(m) * n[0] + t[0]) >> 64;
+			for (int j = 1; j < LIMBS; ++j) {
+				WIDE p = WIDE(m) * n[j] + t[j] + carry;
+				t[j - 1] = p;
+				carry = p >> 64;
+			}
+			s = WIDE(t[LIMBS]) + carry;
+			t[LIMBS - 1] = s;
+			t[LIMBS] = t[LIMBS + 1] + uint64_t(s >> 64);
+		}
+		Limbs r;
+		for (int j = 0; j < LIMBS; ++j)
+			r[j] = t[j];
+		return std::bit_cast<TYPE>(reduce(r, t[LIMBS]));
+	}
+	constexpr TYPE multiply(const TYPE &a, const TYPE &b) const
+	{
+		if constexpr (CONSTANT_TIME || LIMBS <= 4)
+			return cios(a, b);
+		return redc(std::bit_cast<std::array<uint64_t, 2 * LIMBS>>(mul(a, b)));
+	}
+	constexpr TYPE square(const TYPE &a) const
+	{
+		if constexpr (CONSTANT_TIME || LIMBS <= 4)
+			return cios(a, a);
+		return redc(std::bit_cast<std::array<uint64_t, 2 * LIMBS>>(sqr(a)));
+	}
+	constexpr TYPE to_montgomery(const TYPE &a) const
+	{
+		return multiply(a, r2);
+	}
+	constexpr TYPE from_montgomery(const TYPE &a) const
+	{
+		return multiply(a, TYPE(1));
+	}
+	constexpr TYPE select(const TYPE *table, int size, int index) const
+	{
+		if constexpr (CONSTANT_TIME) {
+			Limbs r = {};
+			for (int i = 0; i < size; ++i) {
+				Limbs e = std::bit_cast<Limbs>(table[i]);
+				uint64_t mask = -uint64_t(i == index);
+				for (int j = 0; j < LIMBS; ++j)
+					r[j] |= e[j] & mask;
+			}
+			return std::bit_cast<TYPE>(r);
+		}
+		return table[index];
+	}
+	constexpr TYPE power(const TYPE &base, const TYPE &exponent) const
+	{
+		Limbs e = std::bit_cast<Limbs>(exponent);
+		auto bit = [&e](int i) { return int(e[i / 64] >> (i % 64) & 1); };
+		if constexpr (CONSTANT_TIME) {
+			const int W = 4;
+			TYPE table[1 << W];
+			table[0] = one;
+			table[1] = to_montgomery(base);
+			for (int i = 2; i < (1 << W); ++i)
+				table[i] = multiply(table[i - 1], table[1]);
+			TYPE result = one;
+			for (int i = BITS - W; i >= 0; i -= W) {
+				for (int k = 0; k < W; ++k)
+					result = square(result);
+				result = multiply(result, select(table, 1 << W, e[i / 64] >> (i % 64) & ((1 << W) - 1)));
+			}
+			return from_montgomery(result);
+		}
+		int top = bit_width(exponent);
+		int W = top <= 32 ? 3 : top <= 256 ? 4 : top <= 1024 ? 5 : 6;
+		TYPE table[32];
+		table[0] = to_montgomery(base);
+		TYPE base2 = square(table[0]);
+		for (int i = 1; i < (1 << (W - 1)); ++i)
+			table[i] = multiply(table[i - 1], base2);
+		TYPE result = one;
+		bool started = false;
+		for (int i = top - 1; i >= 0;) {
+			if (!bit(i)) {
+				result = square(result);
+				--i;
+				continue;
+			}
+			int j = std::max(i - W + 1, 0);
+			while (!bit(j))
+				++j;
+			int value = 0;
+			for (int k = i; k >= j; --k) {
+				value = value << 1 | bit(k);
+				if (started)
+					result = square(result);
+			}
+			result = started ? multiply(result, table[value >> 1]) : table[value >> 1];
+			started = true;
+			i = j - 1;
+		}
+		return from_montgomery(result);
+	}
+};
+#endif
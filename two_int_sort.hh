@@ -0,0 +1,99 @@
+/*
+Radix sort of indices by unsigned integer keys
+
+Copyright 2023 Ahmet Inan <xdsopl@gmail.com>
+*/
+
+#pragma once
+
+#include <bit>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+struct SortRecord
+{
+	uint64_t mantissa;
+	uint32_t exponent;
+	int index;
+};
+
+template <typename TYPE>
+SortRecord sort_record(const TYPE &key, int index, bool descending = false)
+{
+	static_assert(sizeof(TYPE) % sizeof(uint64_t) == 0, "TYPE must be a multiple of 64 bits");
+	const int LIMBS = sizeof(TYPE) / sizeof(uint64_t);
+	auto limb = std::bit_cast<std::array<uint64_t, LIMBS>>(key);
+	int k = LIMBS - 1;
+	while (k > 0 && !limb[k])
+		--k;
+	uint64_t mantissa = limb[k];
+	uint32_t exponent = 0;
+	if (mantissa) {
+		int s = std::countl_zero(mantissa);
+		mantissa = mantissa << s | (s && k ? limb[k - 1] >> (64 - s) : 0);
+		exponent = 64 * k + 64 - s;
+	}
+	if (descending) {
+		mantissa = ~mantissa;
+		exponent = ~exponent;
+	}
+	return SortRecord { mantissa, exponent, index };
+}
+
+inline bool same_key(const SortRecord &a, const SortRecord &b)
+{
+	return a.mantissa == b.mantissa && a.exponent == b.exponent;
+}
+
+inline void radix_sort(SortRecord *records, int length)
+{
+	if (length < 2)
+		return;
+	std::vector<SortRecord> buffer(length);
+	SortRecord *input = records, *output = buffer.data();
+	for (int pass = 0; pass < 12; ++pass) {
+		auto digit = [pass](const SortRecord &r) {
+			return pass < 8 ? r.mantissa >> (8 * pass) & 255 : r.exponent >> (8 * (pass - 8)) & 255;
+		};
+		int count[256] = { 0 };
+		for (int i = 0; i < length; ++i)
+			++count[digit(input[i])];
+		if (count[digit(input[0])] == length)
+			continue;
+		for (int i = 0, sum = 0; i < 256; ++i) {
+			int tmp = count[i];
+			count[i] = sum;
+			sum += tmp;
+		}
+		for (int i = 0; i < length; ++i)
+			output[count[digit(input[i])]++] = input[i];
+		std::swap(input, output);
+	}
+	if (input != records)
+		std::copy(input, input + length, records);
+}
+
+template <typename TYPE>
+void sort_by_key(int *index, int length, const TYPE *key, bool descending = false)
+{
+	if (length < 2)
+		return;
+	std::vector<SortRecord> records(length);
+	for (int i = 0; i < length; ++i)
+		records[i] = sort_record(key[index[i]], index[i], descending);
+	radix_sort(records.data(), length);
+	for (int i = 0; i < length; ++i)
+		index[i] = records[i].index;
+	for (int begin = 0, end = 1; begin < length; begin = end++) {
+		while (end < length && same_key(records[end], records[begin]))
+			++end;
+		if (end - begin < 2)
+			continue;
+		if (descending)
+			std::stable_sort(index + begin, index + end, [key](int a, int b){ return key[a] > key[b]; });
+		else
+			std::stable_sort(index + begin, index + end, [key](int a, int b){ return key[a] < key[b]; });
+	}
+}